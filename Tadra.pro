@@ -6,7 +6,7 @@
 
 cache()
 
-QT       += core gui network xml
+QT       += core gui network concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -32,18 +32,31 @@ SOURCES += main.cpp\
     documentbody.cpp \
     documentboxbuttons.cpp \
     gridcoordinategenerator.cpp \
+    gridbucketindex.cpp \
     gridscale.cpp \
     placeroutine.cpp \
     documentlayer.cpp \
     documentbox.cpp \
+    chartlabelcache.cpp \
     chartroutine.cpp \
     colorroutine.cpp \
+    currencychartcache.cpp \
+    currencychartrenderer.cpp \
+    currencychartstore.cpp \
+    currencycharttable.cpp \
     currencychartwidget.cpp \
     currencyinstrument.cpp \
+    currencyreplyparser.cpp \
     numeral.cpp \
+    searchcatalogue.cpp \
     searchengine.cpp \
     searchinput.cpp \
     searchinputhighlight.cpp \
+    searchngramindex.cpp \
+    searchpattern.cpp \
+    searchsession.cpp \
+    searchtoplist.cpp \
+    skylinepacker.cpp \
     timelyaction.cpp
 
 HEADERS  += window.h \
@@ -64,19 +77,32 @@ HEADERS  += window.h \
     documentbody.h \
     documentboxbuttons.h \
     gridcoordinategenerator.h \
+    gridbucketindex.h \
     gridscale.h \
     placeroutine.h \
     indexsortheplert.h \
     documentlayer.h \
     documentbox.h \
+    chartlabelcache.h \
     chartroutine.h \
     colorroutine.h \
+    currencychartcache.h \
+    currencychartrenderer.h \
+    currencychartstore.h \
+    currencycharttable.h \
     currencychartwidget.h \
     currencyinstrument.h \
+    currencyreplyparser.h \
     numeral.h \
+    searchcatalogue.h \
     searchengine.h \
     searchinput.h \
     searchinputhighlight.h \
+    searchngramindex.h \
+    searchpattern.h \
+    searchsession.h \
+    searchtoplist.h \
+    skylinepacker.h \
     timelyaction.h
 
 FORMS += \
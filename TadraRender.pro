@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Headless batch chart renderer: TadraRender --help
+#
+#-------------------------------------------------
+
+QT       += core gui network concurrent
+
+TARGET = TadraRender
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+
+SOURCES += tadrarender.cpp \
+    floatroutine.cpp \
+    design.cpp \
+    chartlabelcache.cpp \
+    chartroutine.cpp \
+    colorroutine.cpp \
+    currencychartrenderer.cpp \
+    currencychartstore.cpp \
+    currencycharttable.cpp \
+    currencyinstrument.cpp \
+    currencyreplyparser.cpp \
+    numeral.cpp
+
+HEADERS  += floatroutine.h \
+    singletont.h \
+    design.h \
+    indexsortheplert.h \
+    chartlabelcache.h \
+    chartroutine.h \
+    colorroutine.h \
+    currencychartrenderer.h \
+    currencychartstore.h \
+    currencycharttable.h \
+    currencyinstrument.h \
+    currencyreplyparser.h \
+    numeral.h
+
+CONFIG += c++11
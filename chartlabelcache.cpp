@@ -0,0 +1,212 @@
+#include "chartlabelcache.h"
+#include <QFontMetricsF>
+#include <QMutexLocker>
+#include <string.h>
+
+static const int DefaultMaximalCount = 1024;
+
+//******************************************************************************************************
+/*!
+ *\struct ChartTextWidthKey
+ *\brief Ключ кэша ширины текста: шрифт и текст.
+*/
+//******************************************************************************************************
+
+ChartTextWidthKey::ChartTextWidthKey()
+    : font()
+    , text()
+{
+
+}
+
+ChartTextWidthKey::ChartTextWidthKey(const QFont &aFont, const QString &aText)
+    : font(aFont)
+    , text(aText)
+{
+
+}
+
+bool ChartTextWidthKey::operator == (const ChartTextWidthKey &another) const
+{
+    return (text == another.text) && (font == another.font);
+}
+
+uint qHash(const ChartTextWidthKey &key)
+{
+    return qHash(key.text) ^ (qHash(key.font) * 31);
+}
+
+
+//******************************************************************************************************
+/*!
+ *\struct ChartNumberTextKey
+ *\brief Ключ кэша подписей чисел: число (побитово, чтобы NaN тоже находился) и формат.
+*/
+//******************************************************************************************************
+
+ChartNumberTextKey::ChartNumberTextKey()
+    : valueBits(0)
+    , format()
+{
+
+}
+
+ChartNumberTextKey::ChartNumberTextKey(double value, const NumeralFormat &aFormat)
+    : valueBits(0)
+    , format(aFormat)
+{
+    memcpy(&valueBits, &value, sizeof(valueBits));
+}
+
+bool ChartNumberTextKey::operator == (const ChartNumberTextKey &another) const
+{
+    return (valueBits == another.valueBits) && (format == another.format);
+}
+
+uint qHash(const ChartNumberTextKey &key)
+{
+    uint flags =
+            (key.format.sign() ? 1 : 0) |
+            (key.format.thousandSeparate() ? 2 : 0) |
+            (key.format.extraPrecision() ? 4 : 0) |
+            (key.format.percent() ? 8 : 0);
+    return qHash(key.valueBits) ^ ((key.format.precision() * 16 + flags) * 31);
+}
+
+
+//******************************************************************************************************
+/*!
+ *\class ChartLabelCache
+ *\brief Кэш подписей шкал графика: ширина текста в шрифте и текст числа в формате.
+ *
+ * Подбор шага шкал и отрисовка меток раз за разом форматируют и измеряют одни и те же подписи.
+ * Оба кэша ограничены по числу записей и вытесняют давно не использованные (QCache).
+ * Отрисовка идёт и в пуле потоков, поэтому доступ защищён мьютексом; сами значения
+ * вычисляются вне блокировки. Счётчики попаданий показывают, насколько кэш помогает.
+ *
+ * Тексты чисел строятся в локали Numeral по умолчанию: после Numeral::setDefaultLocale()
+ * кэш нужно очистить.
+*/
+//******************************************************************************************************
+
+ChartLabelCache::ChartLabelCache()
+    : SingletonT<ChartLabelCache>()
+    , m_mutex()
+    , m_widths(DefaultMaximalCount)
+    , m_texts(DefaultMaximalCount)
+    , m_widthHitCount(0)
+    , m_widthMissCount(0)
+    , m_textHitCount(0)
+    , m_textMissCount(0)
+{
+
+}
+
+double ChartLabelCache::textWidth(const QFont &font, const QString &text)
+{
+    ChartTextWidthKey key(font, text);
+    {
+        QMutexLocker locker(&m_mutex);
+        double *width = m_widths.object(key);
+        if (width != NULL)
+        {
+            m_widthHitCount++;
+            return *width;
+        }
+        m_widthMissCount++;
+    }
+    double result = QFontMetricsF(font).width(text);
+    QMutexLocker locker(&m_mutex);
+    m_widths.insert(key, new double(result));
+    return result;
+}
+
+QString ChartLabelCache::numberText(double value, const NumeralFormat &format)
+{
+    ChartNumberTextKey key(value, format);
+    {
+        QMutexLocker locker(&m_mutex);
+        QString *text = m_texts.object(key);
+        if (text != NULL)
+        {
+            m_textHitCount++;
+            return *text;
+        }
+        m_textMissCount++;
+    }
+    QString result = Numeral::format(value, format);
+    QMutexLocker locker(&m_mutex);
+    m_texts.insert(key, new QString(result));
+    return result;
+}
+
+void ChartLabelCache::setMaximalCount(int value)
+{
+    QMutexLocker locker(&m_mutex);
+    m_widths.setMaxCost(value);
+    m_texts.setMaxCost(value);
+}
+
+int ChartLabelCache::maximalCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_widths.maxCost();
+}
+
+void ChartLabelCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_widths.clear();
+    m_texts.clear();
+}
+
+qint64 ChartLabelCache::widthHitCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_widthHitCount;
+}
+
+qint64 ChartLabelCache::widthMissCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_widthMissCount;
+}
+
+double ChartLabelCache::widthHitRate() const
+{
+    QMutexLocker locker(&m_mutex);
+    return hitRate(m_widthHitCount, m_widthMissCount);
+}
+
+qint64 ChartLabelCache::textHitCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_textHitCount;
+}
+
+qint64 ChartLabelCache::textMissCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_textMissCount;
+}
+
+double ChartLabelCache::textHitRate() const
+{
+    QMutexLocker locker(&m_mutex);
+    return hitRate(m_textHitCount, m_textMissCount);
+}
+
+void ChartLabelCache::resetCounters()
+{
+    QMutexLocker locker(&m_mutex);
+    m_widthHitCount = 0;
+    m_widthMissCount = 0;
+    m_textHitCount = 0;
+    m_textMissCount = 0;
+}
+
+double ChartLabelCache::hitRate(qint64 hitCount, qint64 missCount)
+{
+    qint64 total = hitCount + missCount;
+    return (total > 0) ? (double(hitCount) / double(total)) : 0;
+}
@@ -0,0 +1,61 @@
+#ifndef CHARTLABELCACHE_H
+#define CHARTLABELCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QFont>
+#include <QString>
+#include "singletont.h"
+#include "numeral.h"
+
+struct ChartTextWidthKey
+{
+    QFont font;
+    QString text;
+    ChartTextWidthKey();
+    ChartTextWidthKey(const QFont &aFont, const QString &aText);
+    bool operator == (const ChartTextWidthKey &another) const;
+};
+
+uint qHash(const ChartTextWidthKey &key);
+
+struct ChartNumberTextKey
+{
+    quint64 valueBits;
+    NumeralFormat format;
+    ChartNumberTextKey();
+    ChartNumberTextKey(double value, const NumeralFormat &aFormat);
+    bool operator == (const ChartNumberTextKey &another) const;
+};
+
+uint qHash(const ChartNumberTextKey &key);
+
+class ChartLabelCache : public SingletonT<ChartLabelCache>
+{
+public:
+    ChartLabelCache();
+    double textWidth(const QFont &font, const QString &text);
+    QString numberText(double value, const NumeralFormat &format = NumeralFormat());
+    void setMaximalCount(int value);
+    int maximalCount() const;
+    void clear();
+    qint64 widthHitCount() const;
+    qint64 widthMissCount() const;
+    double widthHitRate() const;
+    qint64 textHitCount() const;
+    qint64 textMissCount() const;
+    double textHitRate() const;
+    void resetCounters();
+
+private:
+    mutable QMutex m_mutex;
+    QCache<ChartTextWidthKey, double> m_widths;
+    QCache<ChartNumberTextKey, QString> m_texts;
+    qint64 m_widthHitCount;
+    qint64 m_widthMissCount;
+    qint64 m_textHitCount;
+    qint64 m_textMissCount;
+    static double hitRate(qint64 hitCount, qint64 missCount);
+};
+
+#endif // CHARTLABELCACHE_H
@@ -3,6 +3,7 @@
 #include <float.h>
 #include <math.h>
 #include "floatroutine.h"
+#include "chartlabelcache.h"
 
 #include <QDebug>
 
@@ -108,6 +109,36 @@ void FloatRange::append(const FloatRange &another)
     }
 }
 
+void FloatRange::append(const double *values, int count)
+{
+    // Первое значение, не равное NaN, задаёт начальный диапазон. Дальше - проход без ветвлений:
+    // сравнение с NaN ложно, поэтому пропуски в данных на результат не влияют.
+    int i = 0;
+    if ((isNaN(min)) || (isNaN(max)))
+    {
+        while ((i < count) && (isNaN(values[i])))
+        {
+            i++;
+        }
+        if (i == count)
+        {
+            return;
+        }
+        min = values[i];
+        max = values[i];
+    }
+    double lo = min;
+    double hi = max;
+    for (; i < count; i++)
+    {
+        double value = values[i];
+        lo = (value < lo) ? value : lo;
+        hi = (value > hi) ? value : hi;
+    }
+    min = lo;
+    max = hi;
+}
+
 void FloatRange::clear()
 {
     min = getNaN();
@@ -132,6 +163,91 @@ QString FloatRange::toString() const
 }
 
 
+//******************************************************************************
+/*!
+\class FloatRangeTable
+Разреженная таблица диапазонов значений: уровень k хранит диапазоны всех
+отрезков длины 2^k. Диапазон любого отрезка - объединение двух перекрывающихся
+отрезков одного уровня, поэтому запрос не зависит от длины отрезка.
+Добавление значений в конец достраивает только хвосты уровней.
+*/
+//******************************************************************************
+
+FloatRangeTable::FloatRangeTable()
+    : m_levels()
+{
+
+}
+
+void FloatRangeTable::clear()
+{
+    m_levels.clear();
+}
+
+int FloatRangeTable::count() const
+{
+    return m_levels.isEmpty() ? 0 : m_levels.first().count();
+}
+
+void FloatRangeTable::append(const double *values, int count)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    if (m_levels.isEmpty())
+    {
+        m_levels.append(QVector<FloatRange>());
+    }
+    QVector<FloatRange> &values0 = m_levels[0];
+    values0.reserve(values0.count() + count);
+    for (int i = 0; i < count; i++)
+    {
+        values0.append(FloatRange(values[i]));
+    }
+
+    int total = values0.count();
+    for (int k = 1; (1 << k) <= total; k++)
+    {
+        if (m_levels.count() <= k)
+        {
+            m_levels.append(QVector<FloatRange>());
+        }
+        const QVector<FloatRange> &lower = m_levels.at(k-1);
+        QVector<FloatRange> &level = m_levels[k];
+        int half = 1 << (k-1);
+        int size = total - (1 << k) + 1;
+        level.reserve(size);
+        for (int i = level.count(); i < size; i++)
+        {
+            FloatRange range = lower.at(i);
+            range.append(lower.at(i + half));
+            level.append(range);
+        }
+    }
+}
+
+FloatRange FloatRangeTable::range(int first, int last) const
+{
+    first = qMax(first, 0);
+    last = qMin(last, count()-1);
+    if (first > last)
+    {
+        return FloatRange();
+    }
+    int length = last - first + 1;
+    int k = 0;
+    while ((2 << k) <= length)
+    {
+        k++;
+    }
+    const QVector<FloatRange> &level = m_levels.at(k);
+    FloatRange result = level.at(first);
+    result.append(level.at(last - (1 << k) + 1));
+    return result;
+}
+
+
 //******************************************************************************
 /*!
 \struct DateTimeRange
@@ -347,6 +463,7 @@ Scale::Scale()
     , m_screenPoints()
     , m_logicRange()
     , m_requestUseExponentialTransformation(false)
+    , m_textHeight(getNaN())
 {
 
 }
@@ -370,6 +487,7 @@ void Scale::setFont(const QFont &value)
     if (m_font != value)
     {
         m_font = value;
+        m_textHeight = getNaN();
         changed();
     }
 }
@@ -500,16 +618,30 @@ void Scale::changed()
     computeParams();
 }
 
+double Scale::textWidth(const QString &text) const
+{
+    // Подбор шага проверяет одни и те же подписи при каждом изменении размеров
+    return ChartLabelCache::instance()->textWidth(font(), text);
+}
+
+double Scale::textHeight() const
+{
+    if (isNaN(m_textHeight))
+    {
+        m_textHeight = QFontMetricsF(font()).height();
+    }
+    return m_textHeight;
+}
+
 bool Scale::isStepStringAvailable(const QString &stepString, double distanceBetween) const
 {
-    QFontMetricsF fm(font());
     if (orientation() == Qt::Horizontal)
     {
-        return (fm.width(stepString) + minimalMarkSpacing()) <= distanceBetween;
+        return (textWidth(stepString) + minimalMarkSpacing()) <= distanceBetween;
     }
     else
     {
-        return (fm.height() + minimalMarkSpacing()) <= distanceBetween;
+        return (textHeight() + minimalMarkSpacing()) <= distanceBetween;
     }
 }
 
@@ -740,17 +872,77 @@ FloatRange FloatScale::stepRange(double step) const
 
 bool FloatScale::isStepAvailable(double step, int tuneDigits) const
 {
-    Numeral numeral(NumeralFormat(false, true, stepPrecision(step, tuneDigits), false, false));
+    NumeralFormat format(false, true, stepPrecision(step, tuneDigits), false, false);
+    ChartLabelCache *cache = ChartLabelCache::instance();
     FloatRange range = stepRange(step);
     double distanceBetween = step * abs(worstScaleCoef());
     return
-            isStepStringAvailable(numeral.toString(range.min), distanceBetween) &&
-            isStepStringAvailable(numeral.toString(range.max), distanceBetween);
+            isStepStringAvailable(cache->numberText(range.min, format), distanceBetween) &&
+            isStepStringAvailable(cache->numberText(range.max, format), distanceBetween);
+}
+
+bool FloatScale::isStepDistanceAvailable(double step) const
+{
+    // То же, что isStepAvailable() для вертикальной шкалы, но без форматирования подписей
+    double distanceBetween = step * abs(worstScaleCoef());
+    return (textHeight() + minimalMarkSpacing()) <= distanceBetween;
+}
+
+bool FloatScale::findStepByDistance(double min, double max)
+{
+    // Подписи вертикальной шкалы занимают высоту строки при любом шаге, поэтому
+    // годятся все шаги не меньше (высота + отступ) / масштаб. Ряд шагов перебора в findStep()
+    // (10^p, 5, 2.5, 2, 1 * 10^(p-1), ...) убывает, и его результат - наименьший годный шаг.
+    // Он находится сразу по десятичному порядку минимального шага: проверяются только
+    // несколько соседних значений ряда, вычисленных теми же выражениями, что и в переборе.
+    double coef = abs(worstScaleCoef());
+    if ((orientation() != Qt::Vertical) || (!(coef > 0)))
+    {
+        return false;
+    }
+    int p = ceil(log(max-min) / log(10.0));
+    double top = pow(10.0, p);
+    if (!isStepDistanceAvailable(top))
+    {
+        m_step = top;
+        m_stepPrecision = stepPrecision(top, 0);
+        return true;
+    }
+
+    static const double multipliers[] = {1, 2, 2.5, 5};
+    static const int tuneDigits[] = {0, 0, 1, 0};
+    int q = floor(log10((textHeight() + minimalMarkSpacing()) / coef));
+    for (int d = qMin(q-1, p-1); d < p; d++)
+    {
+        double base = pow(10.0, d);
+        for (int i = 0; i < 4; i++)
+        {
+            double step = (i == 0) ? base : base * multipliers[i];
+            if (isStepDistanceAvailable(step))
+            {
+                if (step <= FLT_EPSILON)
+                {
+                    // Перебор не спускается до таких шагов - пусть решает он
+                    return false;
+                }
+                m_step = step;
+                m_stepPrecision = stepPrecision(step, tuneDigits[i]);
+                return true;
+            }
+        }
+    }
+    m_step = top;
+    m_stepPrecision = stepPrecision(top, 0);
+    return true;
 }
 
 void FloatScale::findStep(double min, double max)
 {
     m_step = 0;
+    if ((max-min > FLT_EPSILON) && (findStepByDistance(min, max)))
+    {
+        return;
+    }
     if (max-min > FLT_EPSILON)
     {
         int p = ceil(log(max-min) / log(10.0));
@@ -816,20 +1008,103 @@ void FloatScale::computeMarkList()
     {
         // Единственная метка на шкале
         double value = logicRange().singleValue();
-        m_markList << FloatScaleMark(value, Numeral::format(value), logicToScreen(value));
+        m_markList << FloatScaleMark(value, ChartLabelCache::instance()->numberText(value), logicToScreen(value));
     }
     else
     {
         // Диапазон значений на шкале
         FloatRange range = stepRange(m_step);
+        ChartLabelCache *cache = ChartLabelCache::instance();
         for (double value = range.min; ((value <= range.max) && (m_markList.count() < criticalMarkCount)); value += m_step)
         {
-            m_markList << FloatScaleMark(value, Numeral::format(value, m_stepNumeralFormat), logicToScreen(value));
+            m_markList << FloatScaleMark(value, cache->numberText(value, m_stepNumeralFormat), logicToScreen(value));
         }
     }
 }
 
 
+//******************************************************************************
+/*!
+Время на шкале дат - целое число секунд местного (настенного) времени от
+1970-01-01 00:00, без учёта часового пояса. Календарные вычисления ведутся
+в целых числах по пролептическому григорианскому календарю, как и в QDate.
+*/
+//******************************************************************************
+
+static const qint64 SecondsPerDay = 24*60*60;
+static const qint64 EpochJulianDay = 2440588; // 1970-01-01
+
+static qint64 floorDivide(qint64 a, qint64 b)
+{
+    qint64 result = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0)))
+    {
+        result--;
+    }
+    return result;
+}
+
+static qint64 daysFromCivil(int year, int month, int day)
+{
+    qint64 y = year - ((month <= 2) ? 1 : 0);
+    qint64 era = floorDivide(y, 400);
+    qint64 yearOfEra = y - era*400;
+    qint64 dayOfYear = (153*(month + ((month > 2) ? -3 : 9)) + 2)/5 + day - 1;
+    qint64 dayOfEra = yearOfEra*365 + yearOfEra/4 - yearOfEra/100 + dayOfYear;
+    return era*146097 + dayOfEra - 719468;
+}
+
+static void civilFromDays(qint64 days, int &year, int &month, int &day)
+{
+    days += 719468;
+    qint64 era = floorDivide(days, 146097);
+    qint64 dayOfEra = days - era*146097;
+    qint64 yearOfEra = (dayOfEra - dayOfEra/1460 + dayOfEra/36524 - dayOfEra/146096) / 365;
+    qint64 dayOfYear = dayOfEra - (365*yearOfEra + yearOfEra/4 - yearOfEra/100);
+    qint64 mp = (5*dayOfYear + 2)/153;
+    day = dayOfYear - (153*mp + 2)/5 + 1;
+    month = (mp < 10) ? (mp + 3) : (mp - 9);
+    year = yearOfEra + era*400 + ((month <= 2) ? 1 : 0);
+}
+
+static int daysInMonth(int year, int month)
+{
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = ((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0);
+    return ((month == 2) && (leap)) ? 29 : days[month-1];
+}
+
+static qint64 addMonths(qint64 value, int months)
+{
+    // Как QDate::addMonths(): день, которого нет в новом месяце, заменяется последним днём месяца
+    qint64 days = floorDivide(value, SecondsPerDay);
+    qint64 secs = value - days*SecondsPerDay;
+    int year, month, day;
+    civilFromDays(days, year, month, day);
+    qint64 total = qint64(year)*12 + (month - 1) + months;
+    year = floorDivide(total, 12);
+    month = total - qint64(year)*12 + 1;
+    day = qMin(day, daysInMonth(year, month));
+    return daysFromCivil(year, month, day)*SecondsPerDay + secs;
+}
+
+static qint64 epochDays(const QDate &date)
+{
+    return date.toJulianDay() - EpochJulianDay;
+}
+
+static qint64 toEpochSeconds(const QDateTime &value)
+{
+    return epochDays(value.date())*SecondsPerDay + QTime(0, 0).secsTo(value.time());
+}
+
+static QDateTime fromEpochSeconds(qint64 value)
+{
+    qint64 days = floorDivide(value, SecondsPerDay);
+    return QDateTime(QDate::fromJulianDay(days + EpochJulianDay), QTime(0, 0).addSecs(value - days*SecondsPerDay));
+}
+
+
 //******************************************************************************
 /*!
 \struct DateTimeScaleStep
@@ -872,59 +1147,55 @@ int DateTimeScaleStep::seconds() const
     }
     else
     {
-        QDateTime current = QDateTime::currentDateTime();
-        QDateTime next = add(current, 1);
-        result = current.secsTo(next);
+        qint64 current = epochDays(QDate::currentDate()) * SecondsPerDay;
+        result = add(current, 1) - current;
     }
     return result;
 }
 
-QDateTime DateTimeScaleStep::floorValue(const QDateTime &baseValue) const
+qint64 DateTimeScaleStep::floorValue(qint64 baseValue) const
 {
-    QDateTime result;
+    qint64 result = baseValue;
+    qint64 days = floorDivide(baseValue, SecondsPerDay);
     if (isIntraday())
     {
-        int secsTo = QTime(0, 0).secsTo(baseValue.time());
+        qint64 secsTo = baseValue - days*SecondsPerDay;
         int interval = seconds();
-        int intervals = secsTo / interval;
-        result = QDateTime(baseValue.date(), QTime(0, 0).addSecs(intervals*interval));
+        result = days*SecondsPerDay + (secsTo / interval)*interval;
     }
     else if ((type == Day) || (type == Week))
     {
-        QDate anchor(2007, 01, 01); // понедельник
-        int days = anchor.daysTo(baseValue.date());
+        qint64 anchor = daysFromCivil(2007, 1, 1); // понедельник
         int interval = (type == Week)? (count*7) : count;
-        int intervals = days / interval;
-        if ((days % interval) < 0)
-        {
-            intervals--;
-        }
-        result = QDateTime(anchor.addDays(interval*intervals));
+        qint64 intervals = floorDivide(days - anchor, interval);
+        result = (anchor + interval*intervals) * SecondsPerDay;
     }
-    else if (type == Month)
-    {
-        int months = baseValue.date().month() - 1;
-        int intervals = months / count;
-        result = QDateTime(QDate(baseValue.date().year(), intervals*count + 1, 1));
-    }
-    else if (type == Quarter)
-    {
-        int months = baseValue.date().month() - 1;
-        int intervals = months / count / 3;
-        result = QDateTime(QDate(baseValue.date().year(), intervals*count*3 + 1, 1));
-    }
-    else if (type == Year)
+    else
     {
-        int years = baseValue.date().year();
-        int intervals = years / count;
-        result = QDateTime(QDate(intervals*count, 1, 1));
+        int year, month, day;
+        civilFromDays(days, year, month, day);
+        if (type == Month)
+        {
+            int intervals = (month - 1) / count;
+            result = daysFromCivil(year, intervals*count + 1, 1) * SecondsPerDay;
+        }
+        else if (type == Quarter)
+        {
+            int intervals = (month - 1) / count / 3;
+            result = daysFromCivil(year, intervals*count*3 + 1, 1) * SecondsPerDay;
+        }
+        else if (type == Year)
+        {
+            int intervals = year / count;
+            result = daysFromCivil(intervals*count, 1, 1) * SecondsPerDay;
+        }
     }
     return result;
 }
 
-QDateTime DateTimeScaleStep::ceilValue(const QDateTime &baseValue) const
+qint64 DateTimeScaleStep::ceilValue(qint64 baseValue) const
 {
-    QDateTime result = floorValue(baseValue);
+    qint64 result = floorValue(baseValue);
     if (result < baseValue)
     {
         result = add(result, 1);
@@ -932,33 +1203,48 @@ QDateTime DateTimeScaleStep::ceilValue(const QDateTime &baseValue) const
     return result;
 }
 
-QDateTime DateTimeScaleStep::add(const QDateTime &startValue, int intervals) const
+qint64 DateTimeScaleStep::add(qint64 startValue, int intervals) const
 {
-    QDateTime result;
+    qint64 result = startValue;
     if (isIntraday())
     {
-        result = startValue.addSecs(seconds()*intervals);
+        result = startValue + qint64(seconds())*intervals;
     }
     else if ((type == Day) || (type == Week))
     {
         int interval = (type == Week)? (count*7) : count;
-        result = startValue.addDays(interval*intervals);
+        result = startValue + qint64(interval)*intervals*SecondsPerDay;
     }
     else if (type == Month)
     {
-        result = startValue.addMonths(count*intervals);
+        result = addMonths(startValue, count*intervals);
     }
     else if (type == Quarter)
     {
-        result = startValue.addMonths(count*intervals*3);
+        result = addMonths(startValue, count*intervals*3);
     }
     else if (type == Year)
     {
-        result = startValue.addYears(count*intervals);
+        result = addMonths(startValue, count*intervals*12);
     }
     return result;
 }
 
+QDateTime DateTimeScaleStep::floorValue(const QDateTime &baseValue) const
+{
+    return fromEpochSeconds(floorValue(toEpochSeconds(baseValue)));
+}
+
+QDateTime DateTimeScaleStep::ceilValue(const QDateTime &baseValue) const
+{
+    return fromEpochSeconds(ceilValue(toEpochSeconds(baseValue)));
+}
+
+QDateTime DateTimeScaleStep::add(const QDateTime &startValue, int intervals) const
+{
+    return fromEpochSeconds(add(toEpochSeconds(startValue), intervals));
+}
+
 QString DateTimeScaleStep::format(const QDateTime &testValue) const
 {
     QString result = "hh:mm dd MMM yyyyy";
@@ -1086,13 +1372,47 @@ DateTimeScale::DateTimeScale()
 
 void DateTimeScale::setValues(const QList<QDateTime> &value)
 {
-    m_values = value;
+    m_values.clear();
+    m_values.reserve(value.count());
+    foreach (const QDateTime &dateTime, value)
+    {
+        m_values << toEpochSeconds(dateTime);
+    }
     qSort(m_values);
     setLogicRange(FloatRange(0, m_values.count()-1));
     changed();
 }
 
+void DateTimeScale::setJulianDays(const QVector<qint32> &value)
+{
+    // Даты таблицы графика обычно уже упорядочены - тогда сортировка не нужна
+    m_values.resize(value.count());
+    bool sorted = true;
+    for (int i = 0; i < value.count(); i++)
+    {
+        sorted = sorted && ((i == 0) || (value[i-1] <= value[i]));
+        m_values[i] = (value[i] - EpochJulianDay) * SecondsPerDay;
+    }
+    if (!sorted)
+    {
+        qSort(m_values);
+    }
+    setLogicRange(FloatRange(0, m_values.count()-1));
+    changed();
+}
+
 QList<QDateTime> DateTimeScale::values() const
+{
+    QList<QDateTime> result;
+    result.reserve(m_values.count());
+    foreach (qint64 value, m_values)
+    {
+        result << fromEpochSeconds(value);
+    }
+    return result;
+}
+
+const QVector<qint64>& DateTimeScale::epochValues() const
 {
     return m_values;
 }
@@ -1113,13 +1433,7 @@ bool DateTimeScale::intradayFlag() const
 
 double DateTimeScale::dateTimeToLogic(const QDateTime &dateTime) const
 {
-    double result = getNaN();
-    if (!m_values.isEmpty())
-    {
-        QList<QDateTime>::const_iterator iter = qLowerBound(m_values.constBegin(), m_values.constEnd(), dateTime);
-        return qBound(0, iter - m_values.constBegin(), m_values.count()-1);
-    }
-    return result;
+    return epochToLogic(toEpochSeconds(dateTime));
 }
 
 double DateTimeScale::dateTimeToScreen(const QDateTime &dateTime) const
@@ -1132,7 +1446,7 @@ QDateTime DateTimeScale::logicToDateTime(double logic) const
     QDateTime result;
     if (!m_values.isEmpty())
     {
-        return m_values[qBound(0, qRound(logic), m_values.count()-1)];
+        return fromEpochSeconds(m_values[qBound(0, qRound(logic), m_values.count()-1)]);
     }
     return result;
 }
@@ -1142,13 +1456,26 @@ QDateTime DateTimeScale::screenToDateTime(double screen) const
     return logicToDateTime(screenToLogic(screen));
 }
 
+double DateTimeScale::epochToLogic(qint64 value) const
+{
+    double result = getNaN();
+    if (!m_values.isEmpty())
+    {
+        const qint64 *begin = m_values.constData();
+        const qint64 *iter = qLowerBound(begin, begin + m_values.count(), value);
+        return qBound(0, int(iter - begin), m_values.count()-1);
+    }
+    return result;
+}
+
 DateTimeRange DateTimeScale::dateTimeRange() const
 {
     DateTimeRange result;
-    if (!m_values.isEmpty())
+    qint64 min, max;
+    if (epochRange(min, max))
     {
-        result << m_values.first();
-        result << m_values.last();
+        result << fromEpochSeconds(min);
+        result << fromEpochSeconds(max);
     }
     return result;
 }
@@ -1193,10 +1520,35 @@ void DateTimeScale::initializePossibleSteps()
     m_possibleSteps.append(DateTimeScaleStep(DateTimeScaleStep::Year, 8));
 }
 
-DateTimeRange DateTimeScale::stepRange(const DateTimeScaleStep &step) const
+bool DateTimeScale::epochRange(qint64 &min, qint64 &max) const
 {
-    DateTimeRange r = dateTimeRange();
-    return DateTimeRange(step.ceilValue(r.min), step.floorValue(r.max));
+    // Диапазон видимых дат: логический диапазон шкалы может охватывать только часть значений
+    if (m_values.isEmpty())
+    {
+        return false;
+    }
+    int first = 0;
+    int last = m_values.count()-1;
+    FloatRange r = logicRange();
+    if (r.isValid())
+    {
+        first = qBound(0, int(ceil(r.min)), last);
+        last = qBound(first, int(floor(r.max)), last);
+    }
+    min = m_values[first];
+    max = m_values[last];
+    return true;
+}
+
+bool DateTimeScale::stepRange(const DateTimeScaleStep &step, qint64 &min, qint64 &max) const
+{
+    if (!epochRange(min, max))
+    {
+        return false;
+    }
+    min = step.ceilValue(min);
+    max = step.floorValue(max);
+    return true;
 }
 
 bool DateTimeScale::isStepAvailable(const DateTimeScaleStep &step) const
@@ -1206,13 +1558,14 @@ bool DateTimeScale::isStepAvailable(const DateTimeScaleStep &step) const
         return false;
     }
 
-    DateTimeRange range = dateTimeRange();
-    double markCount = double(range.secondsSpan()) / double(step.seconds());
-    double logicLength = double(values().count()) / markCount;
+    qint64 min, max;
+    epochRange(min, max);
+    double markCount = double(max - min) / double(step.seconds());
+    double logicLength = (logicRange().length() + 1) / markCount;
     double distanceBetween = logicLength * worstScaleCoef();
     return
-            isStepStringAvailable(step.format(range.min), distanceBetween) &&
-            isStepStringAvailable(step.format(range.max), distanceBetween);
+            isStepStringAvailable(step.format(fromEpochSeconds(min)), distanceBetween) &&
+            isStepStringAvailable(step.format(fromEpochSeconds(max)), distanceBetween);
 }
 
 void DateTimeScale::computeStep()
@@ -1227,8 +1580,8 @@ void DateTimeScale::computeStep()
         m_step = DateTimeScaleStep(DateTimeScaleStep::Day, 1);
     }
 
-    DateTimeRange r = dateTimeRange();
-    if (r.secondsSpan() > 0)
+    qint64 min, max;
+    if ((epochRange(min, max)) && (max > min))
     {
         // Есть диапазон значений. Подбор шага.
         foreach (const DateTimeScaleStep &step, m_possibleSteps)
@@ -1246,34 +1599,134 @@ void DateTimeScale::computeMarkList()
 {
     m_markList.clear();
 
-    DateTimeRange r = dateTimeRange();
-    if (!r.isValid())
+    qint64 min, max;
+    if (!epochRange(min, max))
     {
         return;
     }
 
-    if (r.isSingleValue())
+    if (min == max)
     {
-        QString format = m_step.format(r.min);
-        m_markList << DateTimeScaleMark(r.min, r.min.toString(format), dateTimeToScreen(r.min));
+        QDateTime value = fromEpochSeconds(min);
+        QString format = m_step.format(value);
+        m_markList << DateTimeScaleMark(value, value.toString(format), logicToScreen(epochToLogic(min)));
     }
     else
     {
-        DateTimeRange range = stepRange(m_step);
-        QString format = qMax(m_step.format(range.min), m_step.format(range.max));
-        QDateTime currentDateTime = range.max;
+        // Метки перебираются в целых секундах; QDateTime создаётся только для подписи
+        stepRange(m_step, min, max);
+        QString format = qMax(m_step.format(fromEpochSeconds(min)), m_step.format(fromEpochSeconds(max)));
+        qint64 current = max;
         int intervals = 0;
-        QFontMetricsF fm(font());
-        while (currentDateTime >= range.min)
+        while (current >= min)
         {
-            DateTimeScaleMark currentMark(currentDateTime, currentDateTime.toString(format), dateTimeToScreen(currentDateTime));
-            double textSize = (orientation() == Qt::Horizontal) ? fm.width(currentMark.text) : fm.height();
+            QDateTime currentDateTime = fromEpochSeconds(current);
+            DateTimeScaleMark currentMark(currentDateTime, currentDateTime.toString(format), logicToScreen(epochToLogic(current)));
+            double textSize = (orientation() == Qt::Horizontal) ? textWidth(currentMark.text) : textHeight();
             if ((m_markList.isEmpty()) || (m_markList.first().position >= currentMark.position + textSize))
             {
                 m_markList.insert(0, currentMark);
             }
             intervals--;
-            currentDateTime = m_step.add(range.max, intervals);
+            current = m_step.add(max, intervals);
+        }
+    }
+}
+
+
+//******************************************************************************
+/*!
+\class PolylineDecimator
+Прореживание ломаной с монотонными по x точками: в каждом столбце пикселей
+остаются первая, минимальная, максимальная и последняя точки (не более четырёх).
+Внешний вид линии сохраняется, а число вершин ограничено шириной в пикселях.
+*/
+//******************************************************************************
+
+PolylineDecimator::PolylineDecimator()
+    : m_result()
+    , m_hasColumn(false)
+    , m_column(0)
+    , m_pointCount(0)
+    , m_first()
+    , m_last()
+    , m_min()
+    , m_max()
+    , m_minIndex(0)
+    , m_maxIndex(0)
+{
+
+}
+
+void PolylineDecimator::clear()
+{
+    m_result.clear();
+    m_hasColumn = false;
+    m_pointCount = 0;
+}
+
+void PolylineDecimator::append(const QPointF &point)
+{
+    int column = int(floor(point.x()));
+    if ((m_hasColumn) && (column == m_column))
+    {
+        if (point.y() < m_min.y())
+        {
+            m_min = point;
+            m_minIndex = m_pointCount;
+        }
+        if (point.y() > m_max.y())
+        {
+            m_max = point;
+            m_maxIndex = m_pointCount;
+        }
+        m_last = point;
+        m_pointCount++;
+        return;
+    }
+
+    flush();
+    m_hasColumn = true;
+    m_column = column;
+    m_pointCount = 1;
+    m_first = point;
+    m_last = point;
+    m_min = point;
+    m_max = point;
+    m_minIndex = 0;
+    m_maxIndex = 0;
+}
+
+QPolygonF PolylineDecimator::result()
+{
+    flush();
+    return m_result;
+}
+
+void PolylineDecimator::flush()
+{
+    if (!m_hasColumn)
+    {
+        return;
+    }
+    m_result << m_first;
+    if (m_pointCount > 1)
+    {
+        // Экстремумы - в порядке следования, без повторов первой и последней точек
+        int lastIndex = m_pointCount - 1;
+        int index1 = qMin(m_minIndex, m_maxIndex);
+        int index2 = qMax(m_minIndex, m_maxIndex);
+        QPointF point1 = (index1 == m_minIndex) ? m_min : m_max;
+        QPointF point2 = (index2 == m_maxIndex) ? m_max : m_min;
+        if ((index1 > 0) && (index1 < lastIndex))
+        {
+            m_result << point1;
+        }
+        if ((index2 > 0) && (index2 < lastIndex) && (index2 != index1))
+        {
+            m_result << point2;
         }
+        m_result << m_last;
     }
+    m_hasColumn = false;
 }
@@ -3,8 +3,10 @@
 
 #include <QString>
 #include <QStringList>
+#include <QVector>
 #include <QDateTime>
 #include <QFont>
+#include <QPolygonF>
 #include "numeral.h"
 
 struct FloatRange
@@ -24,12 +26,26 @@ struct FloatRange
     bool isSubsetOf(const FloatRange &another) const;
     void append(double value);
     void append(const FloatRange &another);
+    void append(const double *values, int count);
     void clear();
     FloatRange& operator << (double value);
     FloatRange& operator << (const FloatRange &another);
     QString toString() const;
 };
 
+class FloatRangeTable
+{
+public:
+    FloatRangeTable();
+    void clear();
+    int count() const;
+    void append(const double *values, int count);
+    FloatRange range(int first, int last) const;
+
+private:
+    QVector< QVector<FloatRange> > m_levels;
+};
+
 struct DateTimeRange
 {
     QDateTime min;
@@ -93,6 +109,8 @@ public:
 
 protected:
     void changed();
+    double textWidth(const QString &text) const;
+    double textHeight() const;
     bool isStepStringAvailable(const QString &stepString, double distanceBetween) const;
     virtual void computeParams();
 
@@ -134,6 +152,7 @@ private:
     ScreenPoints m_screenPoints;
     FloatRange m_logicRange;
     bool m_requestUseExponentialTransformation;
+    mutable double m_textHeight;
 };
 
 struct FloatScaleMark
@@ -164,6 +183,8 @@ private:
     int stepPrecision(double step, int tuneDigits) const;
     FloatRange stepRange(double step) const;
     bool isStepAvailable(double step, int tuneDigits) const;
+    bool isStepDistanceAvailable(double step) const;
+    bool findStepByDistance(double min, double max);
     void findStep(double min, double max);
     void computeStep();
     void computeMarkList();
@@ -179,6 +200,9 @@ struct DateTimeScaleStep
     DateTimeScaleStep(const DateTimeScaleStep &another);
     bool isIntraday() const;
     int seconds() const;
+    qint64 floorValue(qint64 baseValue) const;
+    qint64 ceilValue(qint64 baseValue) const;
+    qint64 add(qint64 startValue, int intervals) const;
     QDateTime floorValue(const QDateTime &baseValue) const;
     QDateTime ceilValue(const QDateTime &baseValue) const;
     QDateTime add(const QDateTime &startValue, int intervals) const;
@@ -203,13 +227,16 @@ class DateTimeScale : public Scale
 public:
     DateTimeScale();
     void setValues(const QList<QDateTime> &value);
+    void setJulianDays(const QVector<qint32> &value);
     QList<QDateTime> values() const;
+    const QVector<qint64>& epochValues() const;
     void setIntradayFlag(bool value);
     bool intradayFlag() const;
     double dateTimeToLogic(const QDateTime &dateTime) const;
     double dateTimeToScreen(const QDateTime &dateTime) const;
     QDateTime logicToDateTime(double logic) const;
     QDateTime screenToDateTime(double screen) const;
+    double epochToLogic(qint64 value) const;
     DateTimeRange dateTimeRange() const;
     DateTimeScaleMarkList markList() const;
 
@@ -218,15 +245,38 @@ protected:
 
 private:
     DateTimeScaleSteps m_possibleSteps;
-    QList<QDateTime> m_values;
+    QVector<qint64> m_values;
     bool m_intradayFlag;
     DateTimeScaleStep m_step;
     DateTimeScaleMarkList m_markList;
     void initializePossibleSteps();
-    DateTimeRange stepRange(const DateTimeScaleStep &step) const;
+    bool epochRange(qint64 &min, qint64 &max) const;
+    bool stepRange(const DateTimeScaleStep &step, qint64 &min, qint64 &max) const;
     bool isStepAvailable(const DateTimeScaleStep &step) const;
     void computeStep();
     void computeMarkList();
 };
 
+class PolylineDecimator
+{
+public:
+    PolylineDecimator();
+    void clear();
+    void append(const QPointF &point);
+    QPolygonF result();
+
+private:
+    QPolygonF m_result;
+    bool m_hasColumn;
+    int m_column;
+    int m_pointCount;
+    QPointF m_first;
+    QPointF m_last;
+    QPointF m_min;
+    QPointF m_max;
+    int m_minIndex;
+    int m_maxIndex;
+    void flush();
+};
+
 #endif // CHARTROUTINE_H
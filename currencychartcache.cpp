@@ -0,0 +1,311 @@
+#include "currencychartcache.h"
+#include "currencychartstore.h"
+
+//******************************************************************************************************
+/*!
+ *\struct CurrencyChartCacheKey
+ *\brief Ключ исторических данных в кэше: инструмент и диапазон дат.
+*/
+//******************************************************************************************************
+
+CurrencyChartCacheKey::CurrencyChartCacheKey()
+    : instrumentId()
+    , firstDate()
+    , lastDate()
+{
+
+}
+
+CurrencyChartCacheKey::CurrencyChartCacheKey(const QString &anInstrumentId, const QDate &aFirstDate, const QDate &aLastDate)
+    : instrumentId(anInstrumentId)
+    , firstDate(aFirstDate)
+    , lastDate(aLastDate)
+{
+
+}
+
+bool CurrencyChartCacheKey::operator == (const CurrencyChartCacheKey &another) const
+{
+    return (instrumentId == another.instrumentId) && (firstDate == another.firstDate) && (lastDate == another.lastDate);
+}
+
+bool CurrencyChartCacheKey::operator != (const CurrencyChartCacheKey &another) const
+{
+    return !(operator ==(another));
+}
+
+bool CurrencyChartCacheKey::isValid() const
+{
+    return (!instrumentId.isEmpty()) && (firstDate.isValid()) && (lastDate.isValid()) && (firstDate <= lastDate);
+}
+
+QString CurrencyChartCacheKey::toString() const
+{
+    return QString("%1 %2-%3").arg(instrumentId).arg(firstDate.toString("dd.MM.yyyy")).arg(lastDate.toString("dd.MM.yyyy"));
+}
+
+uint qHash(const CurrencyChartCacheKey &key)
+{
+    return qHash(key.instrumentId) ^ (qHash(key.firstDate) * 31) ^ qHash(key.lastDate);
+}
+
+
+//******************************************************************************************************
+/*!
+ *\class CurrencyChartCache
+ *\brief Общий для всего приложения кэш исторических данных.
+ *
+ * Одинаковые графики (один инструмент, один диапазон дат) подписываются на одну запись кэша:
+ * повторные запросы к серверу, пока ответ ещё не получен, не отправляются, а результат
+ * рассылается всем подписчикам сигналом done(). Таблица хранится в одном экземпляре -
+ * CurrencyChartTable разделяется неявно, пока её никто не изменяет.
+ *
+ * Полностью диапазон загружается только для пустой записи. Дальше запрашиваются лишь даты
+ * после последней известной строки, новые строки дописываются в конец таблицы, а подписчики
+ * узнают о них из сигнала rowsAppended(). Новая запись (например, когда диапазон сдвинулся
+ * на следующий день) заполняется строками уже известной записи того же инструмента, а если
+ * такой нет - строками из CurrencyChartStore. Каждое изменение таблицы сохраняется на диск.
+*/
+//******************************************************************************************************
+
+CurrencyChartCache::CurrencyChartCache()
+    : QObject()
+    , SingletonT<CurrencyChartCache>()
+    , m_manager(NULL)
+    , m_entries()
+    , m_replies()
+    , m_parsers()
+{
+    m_manager = new QNetworkAccessManager(this);
+    connect(m_manager, SIGNAL(finished(QNetworkReply*)), this, SLOT(onManagerFinished(QNetworkReply*)));
+}
+
+CurrencyChartCache::Entry::Entry()
+    : subscriberCount(0)
+    , reply(NULL)
+    , appending(false)
+    , requested()
+    , errorString()
+    , table()
+{
+
+}
+
+void CurrencyChartCache::subscribe(const CurrencyChartCacheKey &key)
+{
+    if (!key.isValid())
+    {
+        return;
+    }
+    if (!m_entries.contains(key))
+    {
+        CurrencyChartTable table = seedTable(key);
+        if (table.isEmpty())
+        {
+            table = storedTable(key);
+        }
+        m_entries[key].table = table;
+    }
+    m_entries[key].subscriberCount++;
+}
+
+void CurrencyChartCache::unsubscribe(const CurrencyChartCacheKey &key)
+{
+    QHash<CurrencyChartCacheKey, Entry>::iterator iter = m_entries.find(key);
+    if (iter == m_entries.end())
+    {
+        return;
+    }
+    iter->subscriberCount--;
+    if (iter->subscriberCount <= 0)
+    {
+        // Данные больше никому не нужны. Запрос прерываем уже после удаления записи,
+        // чтобы onManagerFinished() его проигнорировал.
+        QNetworkReply *reply = iter->reply;
+        m_entries.erase(iter);
+        if (reply != NULL)
+        {
+            reply->abort();
+        }
+    }
+}
+
+bool CurrencyChartCache::refresh(const CurrencyChartCacheKey &key, int maximalAgeInSeconds)
+{
+    QHash<CurrencyChartCacheKey, Entry>::iterator iter = m_entries.find(key);
+    if (iter == m_entries.end())
+    {
+        return false;
+    }
+    if (iter->reply != NULL)
+    {
+        // Запрос уже отправлен другим подписчиком
+        return true;
+    }
+    QDateTime current = QDateTime::currentDateTime();
+    if ((iter->requested.isValid()) && (iter->requested.msecsTo(current) < qint64(maximalAgeInSeconds) * 1000))
+    {
+        // Данные достаточно свежие
+        return false;
+    }
+
+    QDate firstDate = key.firstDate;
+    iter->appending = !iter->table.isEmpty();
+    if (iter->appending)
+    {
+        firstDate = iter->table.date(iter->table.count()-1).addDays(1);
+        if (firstDate > key.lastDate)
+        {
+            // Весь диапазон уже загружен
+            return false;
+        }
+    }
+
+    QNetworkRequest networkRequest;
+    networkRequest.setUrl(QUrl(url(key.instrumentId, firstDate, key.lastDate)));
+    iter->requested = current;
+    iter->reply = m_manager->get(networkRequest);
+    m_replies.insert(iter->reply, key);
+    m_parsers.insert(iter->reply, new CurrencyChartReplyParser());
+    connect(iter->reply, SIGNAL(readyRead()), this, SLOT(onReplyReadyRead()));
+
+    emit loading(key);
+    return true;
+}
+
+bool CurrencyChartCache::isLoading(const CurrencyChartCacheKey &key) const
+{
+    return m_entries.value(key).reply != NULL;
+}
+
+QString CurrencyChartCache::errorString(const CurrencyChartCacheKey &key) const
+{
+    return m_entries.value(key).errorString;
+}
+
+CurrencyChartTable CurrencyChartCache::table(const CurrencyChartCacheKey &key) const
+{
+    return m_entries.value(key).table;
+}
+
+void CurrencyChartCache::onReplyReadyRead()
+{
+    // Ответ разбирается по мере поступления данных
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    CurrencyChartReplyParser *parser = m_parsers.value(reply, NULL);
+    if (parser != NULL)
+    {
+        parser->addData(reply->readAll());
+    }
+}
+
+void CurrencyChartCache::onManagerFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    CurrencyChartCacheKey key = m_replies.take(reply);
+    CurrencyChartReplyParser *parser = m_parsers.take(reply);
+    bool parsed = false;
+    CurrencyChartTable tmpTable;
+    if (parser != NULL)
+    {
+        parser->addData(reply->readAll());
+        parsed = parser->finish();
+        tmpTable = parser->table();
+        delete parser;
+        tmpTable.sortByDate();
+    }
+    QHash<CurrencyChartCacheKey, Entry>::iterator iter = m_entries.find(key);
+    if (iter == m_entries.end())
+    {
+        return;
+    }
+
+    if (iter->reply == reply)
+    {
+        iter->reply = NULL;
+    }
+    bool ok = (reply->error() == QNetworkReply::NoError);
+    iter->errorString = ok ? QString() : reply->errorString();
+    int first = iter->table.count();
+    int appended = 0;
+    bool changed = false;
+    if (parsed)
+    {
+        if (iter->appending)
+        {
+            int from = iter->table.isEmpty() ? 0 : tmpTable.lowerBound(iter->table.date(first-1).addDays(1));
+            for (int i = from; i < tmpTable.count(); i++)
+            {
+                iter->table.append(tmpTable.julianDay(i), tmpTable.value(i), tmpTable.nominal(i));
+                appended++;
+            }
+        }
+        else
+        {
+            iter->table = tmpTable;
+            changed = true;
+        }
+    }
+    if ((changed) || (appended > 0))
+    {
+        CurrencyChartStore::instance()->save(key.instrumentId, key.firstDate, iter->table);
+    }
+    if (appended > 0)
+    {
+        emit rowsAppended(key, first, appended);
+    }
+    emit done(key, ok);
+}
+
+QString CurrencyChartCache::inputDateFormat()
+{
+    return QString("dd/MM/yyyy");
+}
+
+CurrencyChartTable CurrencyChartCache::seedTable(const CurrencyChartCacheKey &key) const
+{
+    // Подходит запись того же инструмента, начинающаяся не позже нового диапазона:
+    // тогда её строки из нового диапазона идут без пропусков и дальше их можно только дописывать.
+    CurrencyChartTable result;
+    for (QHash<CurrencyChartCacheKey, Entry>::const_iterator iter = m_entries.constBegin(); iter != m_entries.constEnd(); ++iter)
+    {
+        const CurrencyChartCacheKey &anotherKey = iter.key();
+        if ((anotherKey.instrumentId != key.instrumentId) || (anotherKey.firstDate > key.firstDate))
+        {
+            continue;
+        }
+        CurrencyChartTable tmpTable = rowsInRange(iter->table, key);
+        if (tmpTable.count() > result.count())
+        {
+            result = tmpTable;
+        }
+    }
+    return result;
+}
+
+CurrencyChartTable CurrencyChartCache::storedTable(const CurrencyChartCacheKey &key)
+{
+    QDate firstDate;
+    CurrencyChartTable table;
+    if ((CurrencyChartStore::instance()->load(key.instrumentId, firstDate, table)) && (firstDate <= key.firstDate))
+    {
+        return rowsInRange(table, key);
+    }
+    return CurrencyChartTable();
+}
+
+CurrencyChartTable CurrencyChartCache::rowsInRange(const CurrencyChartTable &table, const CurrencyChartCacheKey &key)
+{
+    int first = table.lowerBound(key.firstDate);
+    int last = table.lowerBound(key.lastDate.addDays(1));
+    return table.mid(first, last - first);
+}
+
+QString CurrencyChartCache::url(const QString &instrumentId, const QDate &firstDate, const QDate &lastDate)
+{
+    QString result = QString("http://www.cbr.ru/scripts/XML_dynamic.asp?date_req1=%1&date_req2=%2&VAL_NM_RQ=%3")
+            .arg(firstDate.toString(inputDateFormat()))
+            .arg(lastDate.toString(inputDateFormat()))
+            .arg(instrumentId);
+    return result;
+}
@@ -0,0 +1,73 @@
+#ifndef CURRENCYCHARTCACHE_H
+#define CURRENCYCHARTCACHE_H
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QHash>
+#include <QDate>
+#include <QDateTime>
+#include "singletont.h"
+#include "currencycharttable.h"
+#include "currencyreplyparser.h"
+
+struct CurrencyChartCacheKey
+{
+    QString instrumentId;
+    QDate firstDate;
+    QDate lastDate;
+    CurrencyChartCacheKey();
+    CurrencyChartCacheKey(const QString &anInstrumentId, const QDate &aFirstDate, const QDate &aLastDate);
+    bool operator == (const CurrencyChartCacheKey &another) const;
+    bool operator != (const CurrencyChartCacheKey &another) const;
+    bool isValid() const;
+    QString toString() const;
+};
+
+uint qHash(const CurrencyChartCacheKey &key);
+
+class CurrencyChartCache : public QObject, public SingletonT<CurrencyChartCache>
+{
+    Q_OBJECT
+
+public:
+    CurrencyChartCache();
+    void subscribe(const CurrencyChartCacheKey &key);
+    void unsubscribe(const CurrencyChartCacheKey &key);
+    bool refresh(const CurrencyChartCacheKey &key, int maximalAgeInSeconds);
+    bool isLoading(const CurrencyChartCacheKey &key) const;
+    QString errorString(const CurrencyChartCacheKey &key) const;
+    CurrencyChartTable table(const CurrencyChartCacheKey &key) const;
+
+signals:
+    void loading(const CurrencyChartCacheKey &key);
+    void rowsAppended(const CurrencyChartCacheKey &key, int first, int count);
+    void done(const CurrencyChartCacheKey &key, bool ok);
+
+private slots:
+    void onReplyReadyRead();
+    void onManagerFinished(QNetworkReply *reply);
+
+private:
+    struct Entry
+    {
+        int subscriberCount;
+        QNetworkReply *reply;
+        bool appending;
+        QDateTime requested;
+        QString errorString;
+        CurrencyChartTable table;
+        Entry();
+    };
+    QNetworkAccessManager *m_manager;
+    QHash<CurrencyChartCacheKey, Entry> m_entries;
+    QHash<QNetworkReply*, CurrencyChartCacheKey> m_replies;
+    QHash<QNetworkReply*, CurrencyChartReplyParser*> m_parsers;
+    static QString inputDateFormat();
+    CurrencyChartTable seedTable(const CurrencyChartCacheKey &key) const;
+    static CurrencyChartTable storedTable(const CurrencyChartCacheKey &key);
+    static CurrencyChartTable rowsInRange(const CurrencyChartTable &table, const CurrencyChartCacheKey &key);
+    static QString url(const QString &instrumentId, const QDate &firstDate, const QDate &lastDate);
+};
+
+#endif // CURRENCYCHARTCACHE_H
@@ -0,0 +1,514 @@
+#include "currencychartrenderer.h"
+#include <float.h>
+#include <math.h>
+#include "floatroutine.h"
+#include "colorroutine.h"
+#include "numeral.h"
+#include "design.h"
+#include "chartlabelcache.h"
+
+// TODO: Заменить значениями из Design
+static const double ChartFloatScaleWidth = 64;
+static const double ChartDateTimeScaleHeight = 24;
+static const double ChartMinWidth = 192;
+static const double ChartMinHeight = 128;
+static const QColor ChartRaiseColor("#00a300");
+static const QColor ChartUnchangedColor("#505050");
+static const QColor ChartFallColor("#bf0000");
+static const QColor ChartTextColor(Qt::white);
+static const QColor ChartScaleLineColor(Qt::gray);
+static const double ChartFloatScaleMargin = 6;
+static const QColor ChartLineColor1(Qt::white);
+static const double ChartLineWidth1(5);
+static const QColor ChartLineColor2("#008080");
+static const double ChartLineWidth2(1);
+static const double ChartLastMargin(8);
+static const double ChartLastHeight(24);
+static const QColor ChartLastTextColor(Qt::black);
+static const QColor ChartLastBgColor(Qt::white);
+static const int ChartMinimalMarkSpacing(10);
+static const int ChartMinimalVisibleCount(5);
+static const QColor ChartCrosshairColor(255, 255, 255, 160);
+static const double ChartCrosshairTextMargin(4);
+
+//******************************************************************************************************
+/*!
+ *\class CurrencyChartRenderer
+ *\brief Отрисовка графика валюты.
+ *
+ * Хранит всё, что нужно для отрисовки: таблицу, шкалы и размеры. Объект копируется дёшево
+ * (таблица и шкалы разделяются неявно), поэтому копию можно отрисовать в другом потоке,
+ * пока исходный объект продолжает меняться.
+ *
+ * Показывается не обязательно вся таблица, а окно строк (visibleRange), которое меняется
+ * через zoom() и pan(). Диапазон значений в окне берётся из разреженной таблицы за
+ * постоянное время, поэтому масштабирование не требует прохода по данным.
+*/
+//******************************************************************************************************
+
+CurrencyChartRenderer::CurrencyChartRenderer()
+    : m_table()
+    , m_rect()
+    , m_rangeTable()
+    , m_visibleRange()
+    , m_dateTimeScale()
+    , m_floatScale()
+    , m_indicatorLine()
+    , m_indicatorLineValid(false)
+{
+    QFont scaleFont = Design::instance()->font(Design::ChartFont);
+    m_dateTimeScale.setOrientation(Qt::Horizontal);
+    m_dateTimeScale.setIntradayFlag(false);
+    m_dateTimeScale.setMinimalMarkSpacing(ChartMinimalMarkSpacing);
+    m_dateTimeScale.setFont(scaleFont);
+    m_floatScale.setOrientation(Qt::Vertical);
+    m_floatScale.setMinimalMarkSpacing(ChartMinimalMarkSpacing);
+    m_floatScale.setFont(scaleFont);
+}
+
+void CurrencyChartRenderer::setTable(const CurrencyChartTable &value)
+{
+    m_table = value;
+    m_indicatorLineValid = false;
+}
+
+const CurrencyChartTable& CurrencyChartRenderer::table() const
+{
+    return m_table;
+}
+
+void CurrencyChartRenderer::appendRows(const CurrencyChartTable &value, int first)
+{
+    // Строки до first не изменились, поэтому таблица диапазонов только дополняется
+    int previousCount = m_table.count();
+    m_table = value;
+    first = qBound(0, first, previousCount);
+    computeRanges(first);
+    if ((m_visibleRange.isValid()) && (m_visibleRange.max >= previousCount-1))
+    {
+        // Окно, в котором видна последняя строка, сдвигается вслед за новыми строками
+        double shift = (m_table.count()-1) - m_visibleRange.max;
+        m_visibleRange = FloatRange(m_visibleRange.min + shift, m_visibleRange.max + shift);
+    }
+    m_dateTimeScale.setJulianDays(m_table.julianDays());
+    applyVisibleRange();
+}
+
+void CurrencyChartRenderer::setRect(const QRectF &value)
+{
+    m_rect = value;
+    m_dateTimeScale.setScreenPoints(ScreenPoints(rect().left(), rect().right() - ChartFloatScaleWidth));
+    m_floatScale.setScreenPoints(ScreenPoints(rect().bottom() - ChartDateTimeScaleHeight - ChartFloatScaleMargin, rect().top() + ChartFloatScaleMargin));
+    m_indicatorLineValid = false;
+}
+
+QRectF CurrencyChartRenderer::rect() const
+{
+    return m_rect;
+}
+
+QRectF CurrencyChartRenderer::outputRect() const
+{
+    return QRectF(rect().left(), rect().top(), rect().width() - ChartFloatScaleWidth, rect().height() - ChartDateTimeScaleHeight);
+}
+
+void CurrencyChartRenderer::update()
+{
+    computeRanges(0);
+    m_dateTimeScale.setJulianDays(m_table.julianDays());
+    applyVisibleRange();
+}
+
+void CurrencyChartRenderer::setVisibleRange(const FloatRange &value)
+{
+    m_visibleRange = value;
+    applyVisibleRange();
+}
+
+FloatRange CurrencyChartRenderer::visibleRange() const
+{
+    if (m_visibleRange.isValid())
+    {
+        return m_visibleRange;
+    }
+    return FloatRange(0, m_table.count()-1);
+}
+
+void CurrencyChartRenderer::resetVisibleRange()
+{
+    setVisibleRange(FloatRange());
+}
+
+void CurrencyChartRenderer::zoom(double factor, double screenPosition)
+{
+    // Точка под курсором остаётся на месте
+    FloatRange range = visibleRange();
+    if ((!range.isValid()) || (factor <= 0) || (isNaN(factor)))
+    {
+        return;
+    }
+    double anchor = qBound(range.min, m_dateTimeScale.screenToLogic(screenPosition), range.max);
+    double length = qBound(double(ChartMinimalVisibleCount-1), range.length() * factor, double(m_table.count()-1));
+    double k = (range.length() > 0) ? (length / range.length()) : 1;
+    double min = anchor - (anchor - range.min) * k;
+    setVisibleRange(FloatRange(min, min + length));
+}
+
+void CurrencyChartRenderer::pan(double screenDistance)
+{
+    FloatRange range = visibleRange();
+    if (!range.isValid())
+    {
+        return;
+    }
+    double shift = m_dateTimeScale.screenToLogic(0) - m_dateTimeScale.screenToLogic(screenDistance);
+    if (!isNaN(shift))
+    {
+        setVisibleRange(FloatRange(range.min + shift, range.max + shift));
+    }
+}
+
+int CurrencyChartRenderer::rowAt(double screenPosition) const
+{
+    // Логическая координата шкалы дат - номер строки, поэтому ближайшая строка
+    // получается округлением, без поиска по датам
+    if (m_table.isEmpty())
+    {
+        return -1;
+    }
+    double logic = m_dateTimeScale.screenToLogic(screenPosition);
+    if (isNaN(logic))
+    {
+        return -1;
+    }
+    FloatRange range = visibleRange();
+    int first = qBound(0, int(ceil(range.min)), m_table.count()-1);
+    int last = qBound(first, int(floor(range.max)), m_table.count()-1);
+    return qBound(first, qRound(logic), last);
+}
+
+QVector<QRectF> CurrencyChartRenderer::crosshairRects(int row) const
+{
+    // Области, которые занимает перекрестие: вертикальная полоса с датой
+    // и горизонтальная со значением
+    QVector<QRectF> result;
+    if ((row < 0) || (row >= m_table.count()))
+    {
+        return result;
+    }
+    QPointF point = screenPoint(row);
+    result << QRectF(point.x() - 1, rect().top(), 2, rect().height()).united(crosshairDateRect(row));
+    if (!isNaN(point.y()))
+    {
+        result << QRectF(rect().left(), point.y() - 1, rect().width(), 2).united(crosshairValueRect(row));
+    }
+    return result;
+}
+
+void CurrencyChartRenderer::paintCrosshair(QPainter *painter, int row) const
+{
+    if ((row < 0) || (row >= m_table.count()))
+    {
+        return;
+    }
+    QPointF point = screenPoint(row);
+    QRectF r = outputRect();
+
+    painter->save();
+    painter->setPen(ChartCrosshairColor);
+    painter->drawLine(QPointF(point.x(), r.top()), QPointF(point.x(), r.bottom()));
+    if (!isNaN(point.y()))
+    {
+        painter->drawLine(QPointF(r.left(), point.y()), QPointF(r.right(), point.y()));
+    }
+
+    painter->setFont(Design::instance()->font(Design::ChartFont));
+    QRectF dateRect = crosshairDateRect(row);
+    painter->fillRect(dateRect, ChartLastBgColor);
+    painter->setPen(ChartLastTextColor);
+    painter->drawText(dateRect, Qt::AlignCenter, crosshairDateText(row));
+    if (!isNaN(point.y()))
+    {
+        QRectF valueRect = crosshairValueRect(row);
+        painter->fillRect(valueRect, ChartLastBgColor);
+        painter->setFont(Design::instance()->font(Design::ChartLastFont));
+        painter->drawText(valueRect, Qt::AlignCenter, ChartLabelCache::instance()->numberText(m_table.value(row)));
+    }
+    painter->restore();
+}
+
+const DateTimeScale& CurrencyChartRenderer::dateTimeScale() const
+{
+    return m_dateTimeScale;
+}
+
+const FloatScale& CurrencyChartRenderer::floatScale() const
+{
+    return m_floatScale;
+}
+
+QImage CurrencyChartRenderer::render(int devicePixelRatio)
+{
+    QImage result = createImage(devicePixelRatio);
+    if ((!m_table.isEmpty()) && (!result.isNull()))
+    {
+        QPainter painter(&result);
+        painter.translate(-rect().topLeft());
+        paintBackground(&painter);
+        paintDateTimeScale(&painter);
+        paintFloatScale(&painter);
+        paintIndicator(&painter);
+        paintLast(&painter);
+    }
+    return result;
+}
+
+QSizeF CurrencyChartRenderer::minimumSize()
+{
+    return QSizeF(ChartMinWidth, ChartMinHeight);
+}
+
+double CurrencyChartRenderer::changePercent() const
+{
+    double result = getNaN();
+    if (m_table.count() >= 2)
+    {
+        double open = m_table.value(0);
+        if (open > FLT_EPSILON)
+        {
+            result = (m_table.value(m_table.count()-1) - open) / open;
+        }
+    }
+    return result;
+}
+
+QColor CurrencyChartRenderer::baseColor() const
+{
+    double k = qBound(-0.05, changePercent(), +0.05)/0.05;
+    if (k > FLT_EPSILON)
+    {
+        // Зелёный
+        return blendColor(ChartUnchangedColor, ChartRaiseColor, k);
+    }
+    else if (k < -FLT_EPSILON)
+    {
+        // Красный
+        return blendColor(ChartUnchangedColor, ChartFallColor, -k);
+    }
+    else
+    {
+        return ChartUnchangedColor;
+    }
+}
+
+void CurrencyChartRenderer::computeRanges(int first)
+{
+    if (first == 0)
+    {
+        m_rangeTable.clear();
+    }
+    m_rangeTable.append(m_table.values().constData() + first, m_table.count() - first);
+}
+
+void CurrencyChartRenderer::applyVisibleRange()
+{
+    // Окно не выходит за пределы таблицы; окно во всю таблицу не хранится,
+    // чтобы показ всех данных сохранялся при их обновлении
+    int lastIndex = m_table.count()-1;
+    if (m_visibleRange.isValid())
+    {
+        double length = qBound(double(qMin(ChartMinimalVisibleCount-1, lastIndex)), m_visibleRange.length(), double(qMax(lastIndex, 0)));
+        double min = qBound(0.0, m_visibleRange.min, lastIndex - length);
+        m_visibleRange = FloatRange(min, min + length);
+        if ((min <= 0) && (min + length >= lastIndex))
+        {
+            m_visibleRange.clear();
+        }
+    }
+
+    FloatRange range = visibleRange();
+    if (lastIndex >= 0)
+    {
+        m_dateTimeScale.setLogicRange(range);
+        // Соседние с окном строки тоже попадают на график, поэтому учитываются в шкале значений
+        m_floatScale.setLogicRange(m_rangeTable.range(int(floor(range.min)), int(ceil(range.max))));
+    }
+    else
+    {
+        m_floatScale.setLogicRange(FloatRange());
+    }
+    m_indicatorLineValid = false;
+}
+
+QImage CurrencyChartRenderer::createImage(int devicePixelRatio) const
+{
+    QSize size = rect().size().toSize() * devicePixelRatio;
+    if (size.isEmpty())
+    {
+        return QImage();
+    }
+    QImage result(size, QImage::Format_ARGB32_Premultiplied);
+    result.setDevicePixelRatio(devicePixelRatio);
+    result.fill(Qt::transparent);
+    return result;
+}
+
+void CurrencyChartRenderer::paintBackground(QPainter *painter)
+{
+    QColor bgColor = baseColor();
+    QLinearGradient gradient(rect().topLeft(), rect().bottomLeft());
+    gradient.setColorAt(0, bgColor);
+    gradient.setColorAt(1, bgColor.darker());
+    painter->fillRect(rect(), QBrush(gradient));
+}
+
+void CurrencyChartRenderer::paintDateTimeScale(QPainter *painter)
+{
+    QPen linePen(ChartScaleLineColor);
+    linePen.setStyle(Qt::DashLine);
+    QPen textPen(ChartTextColor);
+
+    QFont font = Design::instance()->font(Design::ChartFont);
+    painter->setFont(font);
+    ChartLabelCache *cache = ChartLabelCache::instance();
+    DateTimeScaleMarkList markList = m_dateTimeScale.markList();
+    foreach (const DateTimeScaleMark &mark, markList)
+    {
+        painter->setPen(linePen);
+        painter->drawLine(mark.position, rect().top(), mark.position, rect().bottom());
+        double textWidth = cache->textWidth(font, mark.text)+1;
+        QRectF textRect(mark.position + ChartMinimalMarkSpacing/2.0, rect().bottom() - ChartDateTimeScaleHeight, textWidth, ChartDateTimeScaleHeight);
+        painter->setPen(textPen);
+        painter->drawText(textRect, Qt::AlignCenter, mark.text);
+    }
+}
+
+void CurrencyChartRenderer::paintFloatScale(QPainter *painter)
+{
+    QPen linePen(ChartScaleLineColor);
+    linePen.setStyle(Qt::DashLine);
+    QPen textPen(ChartTextColor);
+
+    QFont font = Design::instance()->font(Design::ChartFont);
+    painter->setFont(font);
+    QFontMetricsF fm(font);
+    FloatScaleMarkList markList = m_floatScale.markList();
+    foreach (const FloatScaleMark &mark, markList)
+    {
+        painter->setPen(linePen);
+        painter->drawLine(rect().left(), mark.position, rect().right() - ChartFloatScaleWidth, mark.position);
+        QRectF textRect(rect().right() - ChartFloatScaleWidth + ChartFloatScaleMargin, mark.position - fm.height()/2, ChartFloatScaleWidth - ChartFloatScaleMargin, fm.height());
+        painter->setPen(textPen);
+        painter->drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter, mark.text);
+    }
+}
+
+QPointF CurrencyChartRenderer::screenPoint(int index) const
+{
+    return QPointF(m_dateTimeScale.logicToScreen(index), m_floatScale.logicToScreen(m_table.value(index)));
+}
+
+void CurrencyChartRenderer::buildIndicatorLine()
+{
+    // Линия прореживается до нескольких точек на столбец пикселей
+    // и хранится до изменения данных, окна или размеров.
+    // Строятся только видимые точки и по одной соседней с каждой стороны.
+    FloatRange range = visibleRange();
+    int first = qMax(0, int(floor(range.min)) - 1);
+    int last = qMin(m_table.count()-1, int(ceil(range.max)) + 1);
+    PolylineDecimator decimator;
+    for (int i = first; i <= last; i++)
+    {
+        decimator.append(screenPoint(i));
+    }
+    m_indicatorLine = decimator.result();
+    m_indicatorLineValid = true;
+}
+
+void CurrencyChartRenderer::paintIndicator(QPainter *painter)
+{
+    if (!m_indicatorLineValid)
+    {
+        buildIndicatorLine();
+    }
+    if (!m_indicatorLine.isEmpty())
+    {
+        painter->save();
+        painter->setClipRect(outputRect());
+        const QPolygonF &pathLine = m_indicatorLine;
+        QPolygonF pathFill = pathLine;
+        double x1 = pathLine.first().x();
+        double x2 = pathLine.last().x();
+        pathFill.insert(0, QPointF(x1, rect().bottom() - ChartDateTimeScaleHeight));
+        pathFill.append(QPointF(x2, rect().bottom() - ChartDateTimeScaleHeight));
+
+        QRectF gr = outputRect();
+        QLinearGradient gradient(gr.topLeft(), gr.bottomLeft());
+        gradient.setColorAt(0, QColor(0, 0, 0, 128));
+        gradient.setColorAt(1, QColor(0, 0, 0, 0));
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(gradient);
+        painter->drawPolygon(pathFill);
+
+        painter->setRenderHint(QPainter::Antialiasing);
+        QPen pen1(ChartLineColor1);
+        pen1.setWidthF(ChartLineWidth1);
+        painter->setPen(pen1);
+        painter->drawPolyline(pathLine);
+        QPen pen2(ChartLineColor2);
+        pen2.setWidthF(ChartLineWidth2);
+        painter->setPen(pen2);
+        painter->drawPolyline(pathLine);
+        painter->restore();
+    }
+    painter->setRenderHint(QPainter::Antialiasing, false);
+}
+
+void CurrencyChartRenderer::paintLast(QPainter *painter)
+{
+    // Метка последнего значения - только когда последняя строка в окне
+    if ((m_table.isEmpty()) || (visibleRange().max < m_table.count()-1))
+    {
+        return;
+    }
+    double last = m_table.value(m_table.count()-1);
+    double y = m_floatScale.logicToScreen(last);
+    QPolygonF polygon;
+    polygon << QPointF(rect().right()-ChartFloatScaleWidth, y);
+    polygon << QPointF(rect().right()-ChartFloatScaleWidth+ChartLastMargin, y-ChartLastHeight/2.0);
+    polygon << QPointF(rect().right(), y-ChartLastHeight/2.0);
+    polygon << QPointF(rect().right(), y+ChartLastHeight/2.0);
+    polygon << QPointF(rect().right()-ChartFloatScaleWidth+ChartLastMargin, y+ChartLastHeight/2.0);
+    polygon << QPointF(rect().right()-ChartFloatScaleWidth, y);
+
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(ChartLastBgColor);
+    painter->drawPolygon(polygon);
+
+    QString text = ChartLabelCache::instance()->numberText(last);
+    QRectF textRect(rect().right()-ChartFloatScaleWidth+ChartLastMargin, y-ChartLastHeight/2.0, ChartFloatScaleWidth-ChartLastMargin, ChartLastHeight);
+    painter->setPen(ChartLastTextColor);
+    painter->setFont(Design::instance()->font(Design::ChartLastFont));
+    painter->drawText(textRect, Qt::AlignCenter, text);
+}
+
+QString CurrencyChartRenderer::crosshairDateText(int row) const
+{
+    return m_table.date(row).toString("dd.MM.yyyy");
+}
+
+QRectF CurrencyChartRenderer::crosshairDateRect(int row) const
+{
+    QFont font = Design::instance()->font(Design::ChartFont);
+    double width = ChartLabelCache::instance()->textWidth(font, crosshairDateText(row)) + ChartCrosshairTextMargin*2;
+    double x = screenPoint(row).x() - width/2.0;
+    x = qBound(rect().left(), x, rect().right() - ChartFloatScaleWidth - width);
+    return QRectF(x, rect().bottom() - ChartDateTimeScaleHeight, width, ChartDateTimeScaleHeight);
+}
+
+QRectF CurrencyChartRenderer::crosshairValueRect(int row) const
+{
+    double y = screenPoint(row).y();
+    return QRectF(rect().right() - ChartFloatScaleWidth, y - ChartLastHeight/2.0, ChartFloatScaleWidth, ChartLastHeight);
+}
@@ -0,0 +1,61 @@
+#ifndef CURRENCYCHARTRENDERER_H
+#define CURRENCYCHARTRENDERER_H
+
+#include <QImage>
+#include <QPainter>
+#include <QPolygonF>
+#include <QRectF>
+#include "currencycharttable.h"
+#include "chartroutine.h"
+
+class CurrencyChartRenderer
+{
+public:
+    CurrencyChartRenderer();
+    void setTable(const CurrencyChartTable &value);
+    const CurrencyChartTable& table() const;
+    void appendRows(const CurrencyChartTable &value, int first);
+    void setRect(const QRectF &value);
+    QRectF rect() const;
+    QRectF outputRect() const;
+    void update();
+    void setVisibleRange(const FloatRange &value);
+    FloatRange visibleRange() const;
+    void resetVisibleRange();
+    void zoom(double factor, double screenPosition);
+    void pan(double screenDistance);
+    int rowAt(double screenPosition) const;
+    QVector<QRectF> crosshairRects(int row) const;
+    void paintCrosshair(QPainter *painter, int row) const;
+    const DateTimeScale& dateTimeScale() const;
+    const FloatScale& floatScale() const;
+    QImage render(int devicePixelRatio);
+    static QSizeF minimumSize();
+
+private:
+    CurrencyChartTable m_table;
+    QRectF m_rect;
+    FloatRangeTable m_rangeTable;
+    FloatRange m_visibleRange;
+    DateTimeScale m_dateTimeScale;
+    FloatScale m_floatScale;
+    QPolygonF m_indicatorLine;
+    bool m_indicatorLineValid;
+    double changePercent() const;
+    QColor baseColor() const;
+    void computeRanges(int first);
+    void applyVisibleRange();
+    QImage createImage(int devicePixelRatio) const;
+    void paintBackground(QPainter *painter);
+    void paintDateTimeScale(QPainter *painter);
+    void paintFloatScale(QPainter *painter);
+    QPointF screenPoint(int index) const;
+    void buildIndicatorLine();
+    void paintIndicator(QPainter *painter);
+    void paintLast(QPainter *painter);
+    QString crosshairDateText(int row) const;
+    QRectF crosshairDateRect(int row) const;
+    QRectF crosshairValueRect(int row) const;
+};
+
+#endif // CURRENCYCHARTRENDERER_H
@@ -0,0 +1,195 @@
+#include "currencychartstore.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <string.h>
+
+// Заголовок файла (все числа little-endian):
+//  0  char[4]  сигнатура "TDCS"
+//  4  quint32  версия формата
+//  8  quint32  количество строк
+// 12  qint32   первая дата диапазона, для которого хранятся данные (юлианский день)
+// 16  quint32  смещение столбца дат (qint32, юлианские дни)
+// 20  quint32  смещение столбца значений (double)
+// 24  quint32  смещение столбца номиналов (double)
+// 28  quint32  резерв
+static const char StoreSignature[4] = {'T', 'D', 'C', 'S'};
+static const quint32 StoreVersion = 1;
+static const int StoreHeaderSize = 32;
+
+static int alignedSize(int size)
+{
+    return (size + 7) & ~7;
+}
+
+// Столбцы лежат после заголовка и выровнены на 8 байт, как их пишет writeFile()
+static bool isColumnOffset(qint64 offset)
+{
+    return (offset >= StoreHeaderSize) && ((offset & 7) == 0);
+}
+
+static void writeDouble(double value, uchar *dest)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint64>(bits, dest);
+}
+
+static double readDouble(const uchar *src)
+{
+    quint64 bits = qFromLittleEndian<quint64>(src);
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+//******************************************************************************************************
+/*!
+ *\class CurrencyChartStore
+ *\brief Хранилище исторических данных на диске.
+ *
+ * Для каждого инструмента - отдельный файл: небольшой заголовок и три столбца (даты, значения,
+ * номиналы) - в том же виде, в каком их хранит CurrencyChartTable. Файл читается через
+ * отображение в память, поэтому график можно показать сразу при открытии, не дожидаясь ответа
+ * сервера. Запись идёт через QSaveFile: новый файл пишется рядом и подменяет старый только после
+ * успешной записи.
+*/
+//******************************************************************************************************
+
+CurrencyChartStore::CurrencyChartStore()
+    : SingletonT<CurrencyChartStore>()
+    , m_directory()
+{
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/series";
+}
+
+void CurrencyChartStore::setDirectory(const QString &value)
+{
+    m_directory = value;
+}
+
+QString CurrencyChartStore::directory() const
+{
+    return m_directory;
+}
+
+bool CurrencyChartStore::load(const QString &instrumentId, QDate &firstDate, CurrencyChartTable &table) const
+{
+    return readFile(fileName(instrumentId), firstDate, table);
+}
+
+bool CurrencyChartStore::save(const QString &instrumentId, const QDate &firstDate, const CurrencyChartTable &table) const
+{
+    if (!QDir().mkpath(m_directory))
+    {
+        return false;
+    }
+    return writeFile(fileName(instrumentId), firstDate, table);
+}
+
+bool CurrencyChartStore::readFile(const QString &fileName, QDate &firstDate, CurrencyChartTable &table)
+{
+    firstDate = QDate();
+    table.clear();
+
+    QFile file(fileName);
+    if ((!file.open(QIODevice::ReadOnly)) || (file.size() < StoreHeaderSize))
+    {
+        return false;
+    }
+    qint64 size = file.size();
+    const uchar *data = file.map(0, size);
+    if (data == NULL)
+    {
+        return false;
+    }
+
+    bool result = false;
+    quint32 rowCount = qFromLittleEndian<quint32>(data + 8);
+    qint64 dateOffset = qFromLittleEndian<quint32>(data + 16);
+    qint64 valueOffset = qFromLittleEndian<quint32>(data + 20);
+    qint64 nominalOffset = qFromLittleEndian<quint32>(data + 24);
+    if (
+        (memcmp(data, StoreSignature, sizeof(StoreSignature)) == 0) &&
+        (qFromLittleEndian<quint32>(data + 4) == StoreVersion) &&
+        (isColumnOffset(dateOffset)) &&
+        (isColumnOffset(valueOffset)) &&
+        (isColumnOffset(nominalOffset)) &&
+        (dateOffset + qint64(rowCount) * 4 <= size) &&
+        (valueOffset + qint64(rowCount) * 8 <= size) &&
+        (nominalOffset + qint64(rowCount) * 8 <= size)
+        )
+    {
+        qint32 firstJulianDay = qFromLittleEndian<qint32>(data + 12);
+        firstDate = QDate::fromJulianDay(firstJulianDay);
+        table.reserve(rowCount);
+        // Даты идут строго по возрастанию и не раньше первой даты диапазона
+        qint64 previousJulianDay = qint64(firstJulianDay) - 1;
+        bool isOrdered = true;
+        for (quint32 i = 0; (i < rowCount) && (isOrdered); i++)
+        {
+            qint32 julianDay = qFromLittleEndian<qint32>(data + dateOffset + i*4);
+            double value = readDouble(data + valueOffset + i*8);
+            double nominal = readDouble(data + nominalOffset + i*8);
+            isOrdered = (julianDay > previousJulianDay);
+            previousJulianDay = julianDay;
+            table.append(julianDay, value, nominal);
+        }
+        result = isOrdered && firstDate.isValid() && table.isValid();
+        if (!result)
+        {
+            firstDate = QDate();
+            table.clear();
+        }
+    }
+    file.unmap(const_cast<uchar*>(data));
+    return result;
+}
+
+bool CurrencyChartStore::writeFile(const QString &fileName, const QDate &firstDate, const CurrencyChartTable &table)
+{
+    int rowCount = table.count();
+    int dateOffset = StoreHeaderSize;
+    int valueOffset = dateOffset + alignedSize(rowCount * 4);
+    int nominalOffset = valueOffset + rowCount * 8;
+    QByteArray buffer(nominalOffset + rowCount * 8, '\0');
+    uchar *data = reinterpret_cast<uchar*>(buffer.data());
+
+    memcpy(data, StoreSignature, sizeof(StoreSignature));
+    qToLittleEndian<quint32>(StoreVersion, data + 4);
+    qToLittleEndian<quint32>(rowCount, data + 8);
+    qToLittleEndian<qint32>(firstDate.toJulianDay(), data + 12);
+    qToLittleEndian<quint32>(dateOffset, data + 16);
+    qToLittleEndian<quint32>(valueOffset, data + 20);
+    qToLittleEndian<quint32>(nominalOffset, data + 24);
+    for (int i = 0; i < rowCount; i++)
+    {
+        qToLittleEndian<qint32>(table.julianDay(i), data + dateOffset + i*4);
+        writeDouble(table.value(i), data + valueOffset + i*8);
+        writeDouble(table.nominal(i), data + nominalOffset + i*8);
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    if (file.write(buffer) != buffer.size())
+    {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+QString CurrencyChartStore::fileName(const QString &instrumentId) const
+{
+    QString name;
+    foreach (const QChar &c, instrumentId)
+    {
+        name += c.isLetterOrNumber() ? c : QChar('_');
+    }
+    return m_directory + "/" + name + ".series";
+}
@@ -0,0 +1,25 @@
+#ifndef CURRENCYCHARTSTORE_H
+#define CURRENCYCHARTSTORE_H
+
+#include <QString>
+#include <QDate>
+#include "singletont.h"
+#include "currencycharttable.h"
+
+class CurrencyChartStore : public SingletonT<CurrencyChartStore>
+{
+public:
+    CurrencyChartStore();
+    void setDirectory(const QString &value);
+    QString directory() const;
+    bool load(const QString &instrumentId, QDate &firstDate, CurrencyChartTable &table) const;
+    bool save(const QString &instrumentId, const QDate &firstDate, const CurrencyChartTable &table) const;
+    static bool readFile(const QString &fileName, QDate &firstDate, CurrencyChartTable &table);
+    static bool writeFile(const QString &fileName, const QDate &firstDate, const CurrencyChartTable &table);
+
+private:
+    QString m_directory;
+    QString fileName(const QString &instrumentId) const;
+};
+
+#endif // CURRENCYCHARTSTORE_H
@@ -0,0 +1,266 @@
+#include "currencycharttable.h"
+#include <limits>
+#include "floatroutine.h"
+#include "indexsortheplert.h"
+
+//******************************************************************************************************
+/*!
+ *\struct CurrencyChartRow
+ *\brief Строка с историческими данными для графика валюты.
+*/
+//******************************************************************************************************
+
+CurrencyChartRow::CurrencyChartRow()
+    : date()
+    , value(getNaN())
+    , nominal(getNaN())
+{
+
+}
+
+CurrencyChartRow::CurrencyChartRow(const QDate &aDate, double aValue, double aNominal)
+    : date(aDate)
+    , value(aValue)
+    , nominal(aNominal)
+{
+
+}
+
+bool CurrencyChartRow::operator == (const CurrencyChartRow &another)
+{
+    return (date == another.date) && (doubleEquals(value, another.value)) && (doubleEquals(nominal, another.nominal));
+}
+
+bool CurrencyChartRow::operator != (const CurrencyChartRow &another)
+{
+    return !(operator ==(another));
+}
+
+bool CurrencyChartRow::isValid() const
+{
+    return (date.isValid()) && (!isNaN(value)) && (!isNaN(nominal));
+}
+
+QString CurrencyChartRow::toString() const
+{
+    return QString("%1 %2 (%3)").arg(date.toString("dd.MM.yyyy")).arg(value).arg(nominal);
+}
+
+bool CurrencyChartRow::lessThan(const CurrencyChartRow &r1, const CurrencyChartRow &r2)
+{
+    return r1.date < r2.date;
+}
+
+
+//******************************************************************************************************
+/*!
+ *\class CurrencyChartTable
+ *\brief Данные (исторические) для графика.
+ *
+ * Хранится по столбцам: даты (юлианские дни), значения и номиналы лежат в отдельных
+ * непрерывных массивах. Отрисовка и расчёт диапазонов проходят по нужному столбцу подряд,
+ * а строка CurrencyChartRow собирается только по запросу. Массивы разделяются неявно.
+*/
+//******************************************************************************************************
+
+// Юлианский день для пустой даты
+static const qint32 InvalidJulianDay = std::numeric_limits<qint32>::min();
+
+class JulianDayIndexSortHelper : public IndexSortHelperT<qint32>
+{
+public:
+    bool isO1LessThanO2(const qint32 &o1, const qint32 &o2) const override
+    {
+        return o1 < o2;
+    }
+};
+
+CurrencyChartTable::CurrencyChartTable()
+    : m_julianDays()
+    , m_values()
+    , m_nominals()
+{
+
+}
+
+int CurrencyChartTable::count() const
+{
+    return m_julianDays.count();
+}
+
+bool CurrencyChartTable::isEmpty() const
+{
+    return m_julianDays.isEmpty();
+}
+
+void CurrencyChartTable::clear()
+{
+    m_julianDays.clear();
+    m_values.clear();
+    m_nominals.clear();
+}
+
+void CurrencyChartTable::reserve(int size)
+{
+    m_julianDays.reserve(size);
+    m_values.reserve(size);
+    m_nominals.reserve(size);
+}
+
+void CurrencyChartTable::append(qint32 julianDay, double value, double nominal)
+{
+    m_julianDays.append(julianDay);
+    m_values.append(value);
+    m_nominals.append(nominal);
+}
+
+void CurrencyChartTable::append(const CurrencyChartRow &row)
+{
+    append(toJulianDay(row.date), row.value, row.nominal);
+}
+
+CurrencyChartTable& CurrencyChartTable::operator << (const CurrencyChartRow &row)
+{
+    append(row);
+    return *this;
+}
+
+CurrencyChartRow CurrencyChartTable::at(int i) const
+{
+    return CurrencyChartRow(date(i), m_values.at(i), m_nominals.at(i));
+}
+
+CurrencyChartRow CurrencyChartTable::operator [] (int i) const
+{
+    return at(i);
+}
+
+CurrencyChartRow CurrencyChartTable::first() const
+{
+    return at(0);
+}
+
+CurrencyChartRow CurrencyChartTable::last() const
+{
+    return at(count()-1);
+}
+
+QDate CurrencyChartTable::date(int i) const
+{
+    return fromJulianDay(m_julianDays.at(i));
+}
+
+qint32 CurrencyChartTable::julianDay(int i) const
+{
+    return m_julianDays.at(i);
+}
+
+double CurrencyChartTable::value(int i) const
+{
+    return m_values.at(i);
+}
+
+double CurrencyChartTable::nominal(int i) const
+{
+    return m_nominals.at(i);
+}
+
+const QVector<qint32>& CurrencyChartTable::julianDays() const
+{
+    return m_julianDays;
+}
+
+const QVector<double>& CurrencyChartTable::values() const
+{
+    return m_values;
+}
+
+const QVector<double>& CurrencyChartTable::nominals() const
+{
+    return m_nominals;
+}
+
+CurrencyChartTable CurrencyChartTable::mid(int first, int length) const
+{
+    CurrencyChartTable result;
+    result.m_julianDays = m_julianDays.mid(first, length);
+    result.m_values = m_values.mid(first, length);
+    result.m_nominals = m_nominals.mid(first, length);
+    return result;
+}
+
+int CurrencyChartTable::lowerBound(const QDate &date) const
+{
+    // Таблица упорядочена по датам
+    return qLowerBound(m_julianDays.constBegin(), m_julianDays.constEnd(), toJulianDay(date)) - m_julianDays.constBegin();
+}
+
+void CurrencyChartTable::sortByDate()
+{
+    bool sorted = true;
+    for (int i = 1; (sorted) && (i < count()); i++)
+    {
+        sorted = (m_julianDays.at(i-1) <= m_julianDays.at(i));
+    }
+    if (sorted)
+    {
+        return;
+    }
+
+    JulianDayIndexSortHelper sorter;
+    sorter.setBaseVector(m_julianDays);
+    qStableSort(sorter.indexes().begin(), sorter.indexes().end(), sorter);
+
+    CurrencyChartTable sortedTable;
+    sortedTable.reserve(count());
+    foreach (int index, sorter.indexes())
+    {
+        sortedTable.append(m_julianDays.at(index), m_values.at(index), m_nominals.at(index));
+    }
+    *this = sortedTable;
+}
+
+bool CurrencyChartTable::operator == (const CurrencyChartTable &another) const
+{
+    return (m_julianDays == another.m_julianDays) && (m_values == another.m_values) && (m_nominals == another.m_nominals);
+}
+
+bool CurrencyChartTable::operator != (const CurrencyChartTable &another) const
+{
+    return !(operator ==(another));
+}
+
+bool CurrencyChartTable::isValid() const
+{
+    bool result = true;
+    for (int i = 0; i < count(); i++)
+    {
+        if ((m_julianDays.at(i) == InvalidJulianDay) || (isNaN(m_values.at(i))) || (isNaN(m_nominals.at(i))))
+        {
+            result = false;
+            break;
+        }
+    }
+    return result;
+}
+
+QStringList CurrencyChartTable::toStringList() const
+{
+    QStringList result;
+    result << QString("Table, rows count = %1").arg(count());
+    for (int i = 0; i < count(); i++)
+    {
+        result << at(i).toString();
+    }
+    return result;
+}
+
+qint32 CurrencyChartTable::toJulianDay(const QDate &date)
+{
+    return date.isValid() ? qint32(date.toJulianDay()) : InvalidJulianDay;
+}
+
+QDate CurrencyChartTable::fromJulianDay(qint32 julianDay)
+{
+    return (julianDay == InvalidJulianDay) ? QDate() : QDate::fromJulianDay(julianDay);
+}
@@ -0,0 +1,60 @@
+#ifndef CURRENCYCHARTTABLE_H
+#define CURRENCYCHARTTABLE_H
+
+#include <QDate>
+#include <QVector>
+#include <QStringList>
+
+struct CurrencyChartRow
+{
+    QDate date;
+    double value;
+    double nominal;
+    CurrencyChartRow();
+    CurrencyChartRow(const QDate &aDate, double aValue, double aNominal);
+    bool operator == (const CurrencyChartRow &another);
+    bool operator != (const CurrencyChartRow &another);
+    bool isValid() const;
+    QString toString() const;
+    static bool lessThan(const CurrencyChartRow &r1, const CurrencyChartRow &r2);
+};
+
+class CurrencyChartTable
+{
+public:
+    CurrencyChartTable();
+    int count() const;
+    bool isEmpty() const;
+    void clear();
+    void reserve(int size);
+    void append(qint32 julianDay, double value, double nominal);
+    void append(const CurrencyChartRow &row);
+    CurrencyChartTable& operator << (const CurrencyChartRow &row);
+    CurrencyChartRow at(int i) const;
+    CurrencyChartRow operator [] (int i) const;
+    CurrencyChartRow first() const;
+    CurrencyChartRow last() const;
+    QDate date(int i) const;
+    qint32 julianDay(int i) const;
+    double value(int i) const;
+    double nominal(int i) const;
+    const QVector<qint32>& julianDays() const;
+    const QVector<double>& values() const;
+    const QVector<double>& nominals() const;
+    CurrencyChartTable mid(int first, int length = -1) const;
+    int lowerBound(const QDate &date) const;
+    void sortByDate();
+    bool operator == (const CurrencyChartTable &another) const;
+    bool operator != (const CurrencyChartTable &another) const;
+    bool isValid() const;
+    QStringList toStringList() const;
+    static qint32 toJulianDay(const QDate &date);
+    static QDate fromJulianDay(qint32 julianDay);
+
+private:
+    QVector<qint32> m_julianDays;
+    QVector<double> m_values;
+    QVector<double> m_nominals;
+};
+
+#endif // CURRENCYCHARTTABLE_H
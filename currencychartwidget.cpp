@@ -1,116 +1,11 @@
 #include "currencychartwidget.h"
-#include <QDomDocument>
-#include <float.h>
+#include <QtConcurrent>
 #include <math.h>
-#include "floatroutine.h"
-#include "colorroutine.h"
-#include "numeral.h"
-#include "design.h"
 
 #include <QDebug>
 
-// TODO: Заменить значениями из Design
-static const double ChartFloatScaleWidth = 64;
-static const double ChartDateTimeScaleHeight = 24;
-static const double ChartMinWidth = 192;
-static const double ChartMinHeight = 128;
-static const QColor ChartRaiseColor("#00a300");
-static const QColor ChartUnchangedColor("#505050");
-static const QColor ChartFallColor("#bf0000");
-static const QColor ChartTextColor(Qt::white);
-static const QColor ChartScaleLineColor(Qt::gray);
-static const double ChartFloatScaleMargin = 6;
-static const QColor ChartLineColor1(Qt::white);
-static const double ChartLineWidth1(5);
-static const QColor ChartLineColor2("#008080");
-static const double ChartLineWidth2(1);
-static const double ChartLastMargin(8);
-static const double ChartLastHeight(24);
-static const QColor ChartLastTextColor(Qt::black);
-static const QColor ChartLastBgColor(Qt::white);
-static const int ChartMinimalMarkSpacing(10);
-
-//******************************************************************************************************
-/*!
- *\struct CurrencyChartRow
- *\brief Строка с историческими данными для графика валюты.
-*/
-//******************************************************************************************************
-
-CurrencyChartRow::CurrencyChartRow()
-    : date()
-    , value(getNaN())
-    , nominal(getNaN())
-{
-
-}
-
-CurrencyChartRow::CurrencyChartRow(const QDate &aDate, double aValue, double aNominal)
-    : date(aDate)
-    , value(aValue)
-    , nominal(aNominal)
-{
-
-}
-
-bool CurrencyChartRow::operator == (const CurrencyChartRow &another)
-{
-    return (date == another.date) && (doubleEquals(value, another.value)) && (doubleEquals(nominal, another.nominal));
-}
-
-bool CurrencyChartRow::operator != (const CurrencyChartRow &another)
-{
-    return !(operator ==(another));
-}
-
-bool CurrencyChartRow::isValid() const
-{
-    return (date.isValid()) && (!isNaN(value)) && (!isNaN(nominal));
-}
-
-QString CurrencyChartRow::toString() const
-{
-    return QString("%1 %2 (%3)").arg(date.toString("dd.MM.yyyy")).arg(value).arg(nominal);
-}
-
-bool CurrencyChartRow::lessThan(const CurrencyChartRow &r1, const CurrencyChartRow &r2)
-{
-    return r1.date < r2.date;
-}
-
-
-//******************************************************************************************************
-/*!
- *\class CurrencyChartTable
- *\brief Данные (исторические) для графика.
-*/
-//******************************************************************************************************
-
-bool CurrencyChartTable::isValid() const
-{
-    bool result = true;
-    for (int i = 0; i < count(); i++)
-    {
-        if (!(this->operator [](i)).isValid())
-        {
-            result = false;
-            break;
-        }
-    }
-    return result;
-}
-
-QStringList CurrencyChartTable::toStringList() const
-{
-    QStringList result;
-    result << QString("Table, rows count = %1").arg(count());
-    for (int i = 0; i < count(); i++)
-    {
-        result << (this->operator [](i)).toString();
-    }
-    return result;
-}
-
+// Шаг колеса мыши (120 единиц) сужает окно графика до этой доли
+static const double ChartZoomFactorPerWheelStep = 0.8;
 
 //******************************************************************************************************
 /*!
@@ -123,7 +18,7 @@ CurrencyChartDataSource::CurrencyChartDataSource(QObject *parent)
     : QObject(parent)
     , m_instrument()
     , m_queryAction(NULL)
-    , m_manager(NULL)
+    , m_key()
     , m_isLoading()
     , m_errorString()
     , m_table()
@@ -131,8 +26,15 @@ CurrencyChartDataSource::CurrencyChartDataSource(QObject *parent)
     m_queryAction = new TimelyAction(this);
     m_queryAction->setPeriodInSeconds(20);
     connect(m_queryAction, SIGNAL(triggered()), this, SLOT(query()));
-    m_manager = new QNetworkAccessManager(this);
-    connect(m_manager, SIGNAL(finished(QNetworkReply*)), this, SLOT(onManagerFinished(QNetworkReply*)));
+    CurrencyChartCache *cache = CurrencyChartCache::instance();
+    connect(cache, SIGNAL(loading(CurrencyChartCacheKey)), this, SLOT(onCacheLoading(CurrencyChartCacheKey)));
+    connect(cache, SIGNAL(rowsAppended(CurrencyChartCacheKey,int,int)), this, SLOT(onCacheRowsAppended(CurrencyChartCacheKey,int,int)));
+    connect(cache, SIGNAL(done(CurrencyChartCacheKey,bool)), this, SLOT(onCacheDone(CurrencyChartCacheKey,bool)));
+}
+
+CurrencyChartDataSource::~CurrencyChartDataSource()
+{
+    CurrencyChartCache::instance()->unsubscribe(m_key);
 }
 
 void CurrencyChartDataSource::setInstrument(const CurrencyInstrument &value)
@@ -141,7 +43,9 @@ void CurrencyChartDataSource::setInstrument(const CurrencyInstrument &value)
     {
         m_instrument = value;
         emit instrumentChanged();
-        setTable(CurrencyChartTable());
+        setKey(currentKey());
+        // Если такой график уже открыт, данные появятся сразу
+        takeFromCache();
         m_queryAction->actShortly();
     }
 }
@@ -178,76 +82,92 @@ void CurrencyChartDataSource::query()
         return;
     }
 
-    m_isLoading = true;
-    m_errorString = QString();
+    // Диапазон дат сдвигается вместе с текущей датой
+    setKey(currentKey());
 
-    QNetworkRequest networkRequest;
-    networkRequest.setUrl(QUrl(url()));
-    m_manager->get(networkRequest);
-
-    emit loading();
+    // Данные, запрошенные не раньше половины периода назад, считаются свежими:
+    // так при любом сдвиге таймеров одинаковые графики делают один запрос за период.
+    if (!CurrencyChartCache::instance()->refresh(m_key, m_queryAction->periodInSeconds() / 2))
+    {
+        takeFromCache();
+    }
 }
 
-void CurrencyChartDataSource::onManagerFinished(QNetworkReply *reply)
+void CurrencyChartDataSource::onCacheLoading(const CurrencyChartCacheKey &key)
 {
-    m_isLoading = false;
-    m_errorString = reply->errorString();
-    parseReply(reply->readAll());
-    emit done(reply->error() == QNetworkReply::NoError);
+    if (key == m_key)
+    {
+        m_isLoading = true;
+        m_errorString = QString();
+        emit loading();
+    }
 }
 
-QString CurrencyChartDataSource::inputDateFormat()
+void CurrencyChartDataSource::onCacheRowsAppended(const CurrencyChartCacheKey &key, int first, int count)
 {
-    return QString("dd/MM/yyyy");
+    if (key != m_key)
+    {
+        return;
+    }
+    if (m_table.count() == first)
+    {
+        // Строки до first у нас те же, что и в кэше - достаточно сообщить о новых
+        m_table = CurrencyChartCache::instance()->table(m_key);
+        emit rowsAppended(first, count);
+    }
+    else
+    {
+        takeFromCache();
+    }
 }
 
-QString CurrencyChartDataSource::outputDateFormat()
+void CurrencyChartDataSource::onCacheDone(const CurrencyChartCacheKey &key, bool ok)
 {
-    return QString("dd.MM.yyyy");
+    if (key == m_key)
+    {
+        takeFromCache();
+        emit done(ok);
+    }
 }
 
-QString CurrencyChartDataSource::url() const
+CurrencyChartCacheKey CurrencyChartDataSource::currentKey() const
 {
-    QDate firstDate = QDate::currentDate().addMonths(-12).addDays(2);
-    QDate lastDate = QDate::currentDate().addDays(1);
-    QString result = QString("http://www.cbr.ru/scripts/XML_dynamic.asp?date_req1=%1&date_req2=%2&VAL_NM_RQ=%3")
-            .arg(firstDate.toString(inputDateFormat()))
-            .arg(lastDate.toString(inputDateFormat()))
-            .arg(instrument().id);
+    CurrencyChartCacheKey result;
+    if (instrument().isValid())
+    {
+        QDate firstDate = QDate::currentDate().addMonths(-12).addDays(2);
+        QDate lastDate = QDate::currentDate().addDays(1);
+        result = CurrencyChartCacheKey(instrument().id, firstDate, lastDate);
+    }
     return result;
 }
 
-void CurrencyChartDataSource::setTable(const CurrencyChartTable &value)
+void CurrencyChartDataSource::setKey(const CurrencyChartCacheKey &value)
 {
-    if (m_table != value)
+    if (m_key != value)
     {
-        m_table = value;
-        emit tableChanged();
+        CurrencyChartCache *cache = CurrencyChartCache::instance();
+        cache->subscribe(value);
+        cache->unsubscribe(m_key);
+        m_key = value;
     }
 }
 
-void CurrencyChartDataSource::parseReply(const QByteArray &replyData)
+void CurrencyChartDataSource::takeFromCache()
+{
+    CurrencyChartCache *cache = CurrencyChartCache::instance();
+    m_isLoading = cache->isLoading(m_key);
+    m_errorString = cache->errorString(m_key);
+    setTable(cache->table(m_key));
+}
+
+void CurrencyChartDataSource::setTable(const CurrencyChartTable &value)
 {
-    QDomDocument document;
-    if (document.setContent(replyData))
+    if (m_table != value)
     {
-        CurrencyChartTable tmpTable;
-        QDomElement de = document.documentElement();
-        for (QDomElement recordElement = de.firstChildElement("Record"); !recordElement.isNull(); recordElement = recordElement.nextSiblingElement("Record"))
-        {
-            QDate date = QDate::fromString(recordElement.attribute("Date"), outputDateFormat());
-            bool valueOk = false;
-            double value = recordElement.firstChildElement("Value").text().replace(",", ".").toDouble(&valueOk);
-            bool nominalOk = false;
-            double nominal = recordElement.firstChildElement("Nominal").text().replace(",", ".").toDouble(&nominalOk);
-            if ((date.isValid()) && (valueOk) && (nominalOk))
-            {
-                tmpTable << CurrencyChartRow(date, value, nominal);
-            }
-        }
-        setTable(tmpTable);
+        m_table = value;
+        emit tableChanged();
     }
-    qSort(m_table.begin(), m_table.end(), CurrencyChartRow::lessThan);
 }
 
 
@@ -261,24 +181,29 @@ void CurrencyChartDataSource::parseReply(const QByteArray &replyData)
 CurrencyChartWorkspace::CurrencyChartWorkspace(QObject *parent)
     : GraphicObject(parent)
     , m_instrument()
-    , m_table()
-    , m_dateTimeScale()
-    , m_floatScale()
+    , m_renderer()
+    , m_asyncRendering(true)
+    , m_frame()
+    , m_generation(0)
+    , m_frameGeneration(-1)
+    , m_renderingGeneration(-1)
+    , m_renderingWatcher(NULL)
+    , m_dragPosition(0)
+    , m_crosshairRow(-1)
 {
-    QFont font;
-    QFont scaleFont = Design::instance()->font(Design::ChartFont);
-    m_dateTimeScale.setOrientation(Qt::Horizontal);
-    m_dateTimeScale.setIntradayFlag(false);
-    m_dateTimeScale.setMinimalMarkSpacing(ChartMinimalMarkSpacing);
-    m_dateTimeScale.setFont(scaleFont);
-    m_floatScale.setOrientation(Qt::Vertical);
-    m_floatScale.setMinimalMarkSpacing(ChartMinimalMarkSpacing);
-    m_floatScale.setFont(scaleFont);
+    m_renderingWatcher = new QFutureWatcher<QImage>(this);
+    connect(m_renderingWatcher, SIGNAL(finished()), this, SLOT(onRenderingFinished()));
 }
 
 void CurrencyChartWorkspace::setInstrument(const CurrencyInstrument &value)
 {
-    m_instrument = value;
+    if (m_instrument != value)
+    {
+        m_instrument = value;
+        m_renderer.resetVisibleRange();
+        m_crosshairRow = -1;
+        invalidateFrame();
+    }
 }
 
 CurrencyInstrument CurrencyChartWorkspace::instrument() const
@@ -288,212 +213,203 @@ CurrencyInstrument CurrencyChartWorkspace::instrument() const
 
 void CurrencyChartWorkspace::setTable(const CurrencyChartTable &value)
 {
-    m_table = value;
+    m_renderer.setTable(value);
+    m_crosshairRow = -1;
+    invalidateFrame();
 }
 
 CurrencyChartTable CurrencyChartWorkspace::table() const
 {
-    return m_table;
+    return m_renderer.table();
+}
+
+void CurrencyChartWorkspace::appendRows(const CurrencyChartTable &value, int first)
+{
+    m_renderer.appendRows(value, first);
+    invalidateFrame();
+}
+
+void CurrencyChartWorkspace::setAsyncRendering(bool value)
+{
+    m_asyncRendering = value;
+}
+
+bool CurrencyChartWorkspace::asyncRendering() const
+{
+    return m_asyncRendering;
 }
 
 void CurrencyChartWorkspace::paint(QPainter *painter)
 {
-    if (!m_table.isEmpty())
+    if (m_renderer.table().isEmpty())
+    {
+        return;
+    }
+    int ratio = qMax(1, painter->device()->devicePixelRatio());
+    if (m_frameGeneration != m_generation)
     {
-        paintBackground(painter);
-        paintDateTimeScale(painter);
-        paintFloatScale(painter);
-        paintIndicator(painter);
-        paintLast(painter);
+        if ((m_asyncRendering) && (isFrameUsable(ratio)))
+        {
+            // Пока новый кадр рисуется в пуле потоков, показываем предыдущий
+            startRendering(ratio);
+        }
+        else
+        {
+            // Показать нечего (первый кадр, изменился размер) - рисуем сразу
+            m_frame = m_renderer.render(ratio);
+            m_frameGeneration = m_generation;
+        }
     }
+    if (!m_frame.isNull())
+    {
+        painter->drawImage(rect().topLeft(), m_frame);
+    }
+    // Перекрестие рисуется поверх готового кадра и в кадр не попадает
+    m_renderer.paintCrosshair(painter, m_crosshairRow);
 }
 
 QSizeF CurrencyChartWorkspace::sizeConstraint(const QSizeF &) const
 {
-    return QSizeF(ChartMinWidth, ChartMinHeight);
+    return CurrencyChartRenderer::minimumSize();
 }
 
 void CurrencyChartWorkspace::resize()
 {
-    m_dateTimeScale.setScreenPoints(ScreenPoints(rect().left(), rect().right() - ChartFloatScaleWidth));
-    m_floatScale.setScreenPoints(ScreenPoints(rect().bottom() - ChartDateTimeScaleHeight - ChartFloatScaleMargin, rect().top() + ChartFloatScaleMargin));
+    m_renderer.setRect(rect());
+    invalidateFrame();
 }
 
 void CurrencyChartWorkspace::update()
 {
-    QList<QDateTime> dateTimeList;
-    FloatRange floatRange;
-    computeRanges(dateTimeList, floatRange);
-    m_dateTimeScale.setValues(dateTimeList);
-    m_floatScale.setLogicRange(floatRange);
-}
-
-QRectF CurrencyChartWorkspace::outputRect() const
-{
-    return QRectF(rect().left(), rect().top(), rect().width() - ChartFloatScaleWidth, rect().height() - ChartDateTimeScaleHeight);
+    m_renderer.update();
+    invalidateFrame();
 }
 
-double CurrencyChartWorkspace::changePercent() const
+HitInfo CurrencyChartWorkspace::hitInfo(const QPointF &point) const
 {
-    double result = getNaN();
-    if (table().count() >= 2)
+    HitInfo result;
+    if (rect().contains(point))
     {
-        double open = table().first().value;
-        if (open > FLT_EPSILON)
+        result.result = true;
+        if (m_renderer.outputRect().contains(point))
         {
-            result = (table().last().value - open) / open;
+            result.cursor = handleUsing() ? Qt::ClosedHandCursor : Qt::OpenHandCursor;
         }
     }
     return result;
 }
 
-QColor CurrencyChartWorkspace::baseColor() const
+bool CurrencyChartWorkspace::handleEvent(UserEvent event)
 {
-    double k = qBound(-0.05, changePercent(), +0.05)/0.05;
-    if (k > FLT_EPSILON)
+    // Колесо мыши - масштаб относительно курсора, перетаскивание - сдвиг,
+    // двойной щелчок - снова вся таблица. Движение мыши без кнопок только
+    // переносит перекрестие, перерисовывая его старое и новое место.
+    // Колесо, которое не изменило масштаб (нет данных или масштаб уже предельный),
+    // не используется - тогда оно прокручивает лист.
+    bool used = (event.type != UserEvent::MouseWheel);
+    bool changed = false;
+    if ((event.type == UserEvent::MouseWheel) && (event.wheelDelta != 0))
     {
-        // Зелёный
-        return blendColor(ChartUnchangedColor, ChartRaiseColor, k);
+        FloatRange range = m_renderer.visibleRange();
+        m_renderer.zoom(pow(ChartZoomFactorPerWheelStep, event.wheelDelta / 120.0), event.mousePosition.x());
+        changed = (m_renderer.visibleRange() != range);
+        used = changed;
     }
-    else if (k < -FLT_EPSILON)
+    if ((event.type == UserEvent::MouseMove) && (!handleUsing()))
     {
-        // Красный
-        return blendColor(ChartUnchangedColor, ChartFallColor, -k);
+        bool inside = m_renderer.outputRect().contains(event.mousePosition);
+        setCrosshairRow(inside ? m_renderer.rowAt(event.mousePosition.x()) : -1);
     }
-    else
+    if (event.type == UserEvent::MouseLeave)
     {
-        return ChartUnchangedColor;
+        setCrosshairRow(-1);
     }
-}
-
-void CurrencyChartWorkspace::computeRanges(QList<QDateTime> &dateTimeList, FloatRange &floatRange) const
-{
-    dateTimeList.clear();
-    floatRange.clear();
-    foreach (const CurrencyChartRow &row, m_table)
+    if ((event.type == UserEvent::MouseDown) && (event.button == Qt::LeftButton) && (m_renderer.outputRect().contains(event.mousePosition)))
     {
-        dateTimeList << QDateTime(row.date);
-        floatRange << row.value;
+        setHandleUsing(true);
+        m_dragPosition = event.mousePosition.x();
     }
+    if ((event.type == UserEvent::MouseMove) && (handleUsing()))
+    {
+        m_renderer.pan(event.mousePosition.x() - m_dragPosition);
+        m_dragPosition = event.mousePosition.x();
+        changed = true;
+    }
+    if (event.type == UserEvent::MouseUp)
+    {
+        setHandleUsing(false);
+    }
+    if ((event.type == UserEvent::MouseDoubleClick) && (event.button == Qt::LeftButton))
+    {
+        m_renderer.resetVisibleRange();
+        changed = true;
+    }
+    if (changed)
+    {
+        if (m_crosshairRow >= 0)
+        {
+            m_crosshairRow = m_renderer.rowAt(event.mousePosition.x());
+        }
+        invalidateFrame();
+        redraw();
+    }
+    return used;
 }
 
-void CurrencyChartWorkspace::paintBackground(QPainter *painter)
-{
-    QColor bgColor = baseColor();
-    QLinearGradient gradient(rect().topLeft(), rect().bottomLeft());
-    gradient.setColorAt(0, bgColor);
-    gradient.setColorAt(1, bgColor.darker());
-    painter->fillRect(rect(), QBrush(gradient));
-}
-
-void CurrencyChartWorkspace::paintDateTimeScale(QPainter *painter)
+void CurrencyChartWorkspace::setCrosshairRow(int row)
 {
-    QPen linePen(ChartScaleLineColor);
-    linePen.setStyle(Qt::DashLine);
-    QPen textPen(ChartTextColor);
-
-    QFont font = Design::instance()->font(Design::ChartFont);
-    painter->setFont(font);
-    QFontMetricsF fm(font);
-    DateTimeScaleMarkList markList = m_dateTimeScale.markList();
-    foreach (const DateTimeScaleMark &mark, markList)
+    if (m_crosshairRow != row)
     {
-        painter->setPen(linePen);
-        painter->drawLine(mark.position, rect().top(), mark.position, rect().bottom());
-        double textWidth = fm.width(mark.text)+1;
-        QRectF textRect(mark.position + ChartMinimalMarkSpacing/2.0, rect().bottom() - ChartDateTimeScaleHeight, textWidth, ChartDateTimeScaleHeight);
-        painter->setPen(textPen);
-        painter->drawText(textRect, Qt::AlignCenter, mark.text);
+        foreach (const QRectF &r, m_renderer.crosshairRects(m_crosshairRow))
+        {
+            redrawRect(r);
+        }
+        m_crosshairRow = row;
+        foreach (const QRectF &r, m_renderer.crosshairRects(m_crosshairRow))
+        {
+            redrawRect(r);
+        }
     }
 }
 
-void CurrencyChartWorkspace::paintFloatScale(QPainter *painter)
+void CurrencyChartWorkspace::onRenderingFinished()
 {
-    QPen linePen(ChartScaleLineColor);
-    linePen.setStyle(Qt::DashLine);
-    QPen textPen(ChartTextColor);
-
-    QFont font = Design::instance()->font(Design::ChartFont);
-    painter->setFont(font);
-    QFontMetricsF fm(font);
-    FloatScaleMarkList markList = m_floatScale.markList();
-    foreach (const FloatScaleMark &mark, markList)
+    if (m_renderingGeneration == m_generation)
     {
-        painter->setPen(linePen);
-        painter->drawLine(rect().left(), mark.position, rect().right() - ChartFloatScaleWidth, mark.position);
-        QRectF textRect(rect().right() - ChartFloatScaleWidth + ChartFloatScaleMargin, mark.position - fm.height()/2, ChartFloatScaleWidth - ChartFloatScaleMargin, fm.height());
-        painter->setPen(textPen);
-        painter->drawText(textRect, Qt::AlignLeft | Qt::AlignVCenter, mark.text);
+        m_frame = m_renderingWatcher->result();
+        m_frameGeneration = m_renderingGeneration;
     }
+    // Устаревший кадр отбрасывается; перерисовка запустит отрисовку актуального
+    redraw();
 }
 
-QPointF CurrencyChartWorkspace::screenPoint(int index) const
+void CurrencyChartWorkspace::invalidateFrame()
 {
-    return QPointF(m_dateTimeScale.logicToScreen(index), m_floatScale.logicToScreen(m_table[index].value));
+    m_generation++;
 }
 
-void CurrencyChartWorkspace::paintIndicator(QPainter *painter)
+bool CurrencyChartWorkspace::isFrameUsable(int devicePixelRatio) const
 {
-    if (!m_table.isEmpty())
-    {
-        QPolygonF pathLine;
-        for (int i = 0; i < m_table.count(); i++)
-        {
-            pathLine << screenPoint(i);
-        }
-        QPolygonF pathFill = pathLine;
-        double x1 = screenPoint(0).x();
-        double x2 = screenPoint(m_table.count()-1).x();
-        pathFill.insert(0, QPointF(x1, rect().bottom() - ChartDateTimeScaleHeight));
-        pathFill.append(QPointF(x2, rect().bottom() - ChartDateTimeScaleHeight));
-
-        QRectF gr = outputRect();
-        QLinearGradient gradient(gr.topLeft(), gr.bottomLeft());
-        gradient.setColorAt(0, QColor(0, 0, 0, 128));
-        gradient.setColorAt(1, QColor(0, 0, 0, 0));
-        painter->setPen(Qt::NoPen);
-        painter->setBrush(gradient);
-        painter->drawPolygon(pathFill);
-
-        painter->setRenderHint(QPainter::Antialiasing);
-        QPen pen1(ChartLineColor1);
-        pen1.setWidthF(ChartLineWidth1);
-        painter->setPen(pen1);
-        painter->drawPolyline(pathLine);
-        QPen pen2(ChartLineColor2);
-        pen2.setWidthF(ChartLineWidth2);
-        painter->setPen(pen2);
-        painter->drawPolyline(pathLine);
-    }
-    painter->setRenderHint(QPainter::Antialiasing, false);
+    return
+        (!m_frame.isNull()) &&
+        (qRound(m_frame.devicePixelRatio()) == devicePixelRatio) &&
+        (m_frame.size() == rect().size().toSize() * devicePixelRatio);
 }
 
-void CurrencyChartWorkspace::paintLast(QPainter *painter)
+void CurrencyChartWorkspace::startRendering(int devicePixelRatio)
 {
-    if (m_table.isEmpty())
+    if ((m_renderingWatcher->isRunning()) || (m_renderingGeneration == m_generation))
     {
+        // Кадр уже рисуется; если он к тому времени устареет, следующий запустится после него
         return;
     }
-    double last = m_table.last().value;
-    double y = m_floatScale.logicToScreen(last);
-    QPolygonF polygon;
-    polygon << QPointF(rect().right()-ChartFloatScaleWidth, y);
-    polygon << QPointF(rect().right()-ChartFloatScaleWidth+ChartLastMargin, y-ChartLastHeight/2.0);
-    polygon << QPointF(rect().right(), y-ChartLastHeight/2.0);
-    polygon << QPointF(rect().right(), y+ChartLastHeight/2.0);
-    polygon << QPointF(rect().right()-ChartFloatScaleWidth+ChartLastMargin, y+ChartLastHeight/2.0);
-    polygon << QPointF(rect().right()-ChartFloatScaleWidth, y);
-
-    painter->setRenderHint(QPainter::Antialiasing);
-    painter->setPen(Qt::NoPen);
-    painter->setBrush(ChartLastBgColor);
-    painter->drawPolygon(polygon);
+    m_renderingGeneration = m_generation;
+    m_renderingWatcher->setFuture(QtConcurrent::run(&CurrencyChartWorkspace::renderSnapshot, m_renderer, devicePixelRatio));
+}
 
-    QString text = Numeral::format(last);
-    QRectF textRect(rect().right()-ChartFloatScaleWidth+ChartLastMargin, y-ChartLastHeight/2.0, ChartFloatScaleWidth-ChartLastMargin, ChartLastHeight);
-    painter->setPen(ChartLastTextColor);
-    painter->setFont(Design::instance()->font(Design::ChartLastFont));
-    painter->drawText(textRect, Qt::AlignCenter, text);
+QImage CurrencyChartWorkspace::renderSnapshot(CurrencyChartRenderer renderer, int devicePixelRatio)
+{
+    return renderer.render(devicePixelRatio);
 }
 
 
@@ -517,6 +433,7 @@ CurrencyChartWidget::CurrencyChartWidget(QWidget *parent)
 
     connect(m_dataSource, SIGNAL(instrumentChanged()), this, SLOT(onDataSourceInstrumentChanged()));
     connect(m_dataSource, SIGNAL(tableChanged()), this, SLOT(onDataSourceTableChanged()));
+    connect(m_dataSource, SIGNAL(rowsAppended(int,int)), this, SLOT(onDataSourceRowsAppended(int,int)));
 }
 
 void CurrencyChartWidget::setInstrument(const CurrencyInstrument &value)
@@ -552,3 +469,9 @@ void CurrencyChartWidget::onDataSourceTableChanged()
     workspace()->update();
     redraw();
 }
+
+void CurrencyChartWidget::onDataSourceRowsAppended(int first, int)
+{
+    workspace()->appendRows(dataSource()->table(), first);
+    redraw();
+}
@@ -1,34 +1,13 @@
 #ifndef CURRENCYCHARTWIDGET_H
 #define CURRENCYCHARTWIDGET_H
 
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QDate>
 #include "currencyinstrument.h"
+#include "currencycharttable.h"
+#include "currencychartcache.h"
 #include "graphicwidget.h"
 #include "timelyaction.h"
-#include "chartroutine.h"
-
-struct CurrencyChartRow
-{
-    QDate date;
-    double value;
-    double nominal;
-    CurrencyChartRow();
-    CurrencyChartRow(const QDate &aDate, double aValue, double aNominal);
-    bool operator == (const CurrencyChartRow &another);
-    bool operator != (const CurrencyChartRow &another);
-    bool isValid() const;
-    QString toString() const;
-    static bool lessThan(const CurrencyChartRow &r1, const CurrencyChartRow &r2);
-};
-
-class CurrencyChartTable : public QList<CurrencyChartRow>
-{
-public:
-    bool isValid() const;
-    QStringList toStringList() const;
-};
+#include "currencychartrenderer.h"
+#include <QFutureWatcher>
 
 class CurrencyChartDataSource : public QObject
 {
@@ -36,6 +15,7 @@ class CurrencyChartDataSource : public QObject
 
 public:
     CurrencyChartDataSource(QObject *parent = NULL);
+    ~CurrencyChartDataSource();
     void setInstrument(const CurrencyInstrument &value);
     CurrencyInstrument instrument() const;
     bool isLoading() const;
@@ -48,23 +28,25 @@ signals:
     void loading();
     void done(bool ok);
     void tableChanged();
+    void rowsAppended(int first, int count);
 
 private slots:
     void query();
-    void onManagerFinished(QNetworkReply *reply);
+    void onCacheLoading(const CurrencyChartCacheKey &key);
+    void onCacheRowsAppended(const CurrencyChartCacheKey &key, int first, int count);
+    void onCacheDone(const CurrencyChartCacheKey &key, bool ok);
 
 private:
     CurrencyInstrument m_instrument;
     TimelyAction *m_queryAction;
-    QNetworkAccessManager *m_manager;
+    CurrencyChartCacheKey m_key;
     bool m_isLoading;
     QString m_errorString;
     CurrencyChartTable m_table;
-    static QString inputDateFormat();
-    static QString outputDateFormat();
-    QString url() const;
+    CurrencyChartCacheKey currentKey() const;
+    void setKey(const CurrencyChartCacheKey &value);
+    void takeFromCache();
     void setTable(const CurrencyChartTable &value);
-    void parseReply(const QByteArray &replyData);
 };
 
 class CurrencyChartWorkspace : public GraphicObject
@@ -77,26 +59,35 @@ public:
     CurrencyInstrument instrument() const;
     void setTable(const CurrencyChartTable &value);
     CurrencyChartTable table() const;
+    void appendRows(const CurrencyChartTable &value, int first);
+    void setAsyncRendering(bool value);
+    bool asyncRendering() const;
     void paint(QPainter *painter) override;
     QSizeF sizeConstraint(const QSizeF &supposedSize) const override;
     void resize() override;
     void update() override;
+    HitInfo hitInfo(const QPointF &point) const override;
+    bool handleEvent(UserEvent event) override;
+
+private slots:
+    void onRenderingFinished();
 
 private:
     CurrencyInstrument m_instrument;
-    CurrencyChartTable m_table;
-    DateTimeScale m_dateTimeScale;
-    FloatScale m_floatScale;
-    QRectF outputRect() const;
-    double changePercent() const;
-    QColor baseColor() const;
-    void computeRanges(QList<QDateTime> &dateTimeList, FloatRange &floatRange) const;
-    void paintBackground(QPainter *painter);
-    void paintDateTimeScale(QPainter *painter);
-    void paintFloatScale(QPainter *painter);
-    QPointF screenPoint(int index) const;
-    void paintIndicator(QPainter *painter);
-    void paintLast(QPainter *painter);
+    CurrencyChartRenderer m_renderer;
+    bool m_asyncRendering;
+    QImage m_frame;
+    int m_generation;
+    int m_frameGeneration;
+    int m_renderingGeneration;
+    QFutureWatcher<QImage> *m_renderingWatcher;
+    double m_dragPosition;
+    int m_crosshairRow;
+    void setCrosshairRow(int row);
+    void invalidateFrame();
+    bool isFrameUsable(int devicePixelRatio) const;
+    void startRendering(int devicePixelRatio);
+    static QImage renderSnapshot(CurrencyChartRenderer renderer, int devicePixelRatio);
 };
 
 class CurrencyChartWidget : public GraphicWidget
@@ -113,6 +104,7 @@ public:
 private slots:
     void onDataSourceInstrumentChanged();
     void onDataSourceTableChanged();
+    void onDataSourceRowsAppended(int first, int count);
 
 private:
     CurrencyChartDataSource *m_dataSource;
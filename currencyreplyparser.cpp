@@ -0,0 +1,271 @@
+#include "currencyreplyparser.h"
+#include "floatroutine.h"
+
+//******************************************************************************************************
+/*!
+ *\class CurrencyReplyParser
+ *\brief Потоковый разбор XML-ответа сервера ЦБ РФ.
+ *
+ * Данные передаются через addData() по мере поступления из QNetworkReply и сразу разбираются,
+ * дерево документа не строится. Когда ответ получен полностью, finish() сообщает, был ли документ
+ * корректным.
+*/
+//******************************************************************************************************
+
+CurrencyReplyParser::CurrencyReplyParser()
+    : m_reader()
+    , m_text()
+{
+
+}
+
+CurrencyReplyParser::~CurrencyReplyParser()
+{
+
+}
+
+void CurrencyReplyParser::addData(const QByteArray &data)
+{
+    m_reader.addData(data);
+    parse();
+}
+
+bool CurrencyReplyParser::finish()
+{
+    parse();
+    return !m_reader.hasError();
+}
+
+bool CurrencyReplyParser::parseDecimal(const QStringRef &text, double &value)
+{
+    // Числа в ответах ЦБ РФ - с запятой в качестве разделителя (например, "72,9299").
+    // Мантисса набирается целым числом и делится на точную степень десяти, что даёт
+    // тот же результат, что и QString::toDouble(). Всё необычное разбирается медленным путём.
+    static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    static const quint64 maximalExactMantissa = Q_UINT64_C(1) << 53;
+
+    const QChar *begin = text.constData();
+    const QChar *end = begin + text.length();
+    while ((begin < end) && (begin->isSpace()))
+    {
+        begin++;
+    }
+    while ((end > begin) && ((end-1)->isSpace()))
+    {
+        end--;
+    }
+
+    bool negative = false;
+    if ((begin < end) && ((*begin == QChar('-')) || (*begin == QChar('+'))))
+    {
+        negative = (*begin == QChar('-'));
+        begin++;
+    }
+    quint64 mantissa = 0;
+    int digits = 0;
+    int fractionDigits = -1;
+    bool fast = (begin < end);
+    for (const QChar *c = begin; (fast) && (c < end); c++)
+    {
+        ushort u = c->unicode();
+        if ((u >= '0') && (u <= '9'))
+        {
+            mantissa = mantissa*10 + (u - '0');
+            digits++;
+            if (fractionDigits >= 0)
+            {
+                fractionDigits++;
+            }
+            fast = (mantissa <= maximalExactMantissa);
+        }
+        else if (((u == ',') || (u == '.')) && (fractionDigits < 0))
+        {
+            fractionDigits = 0;
+        }
+        else
+        {
+            fast = false;
+        }
+    }
+    fast = fast && (digits > 0) && (fractionDigits <= 22);
+
+    if (fast)
+    {
+        value = double(mantissa) / powersOfTen[qMax(fractionDigits, 0)];
+        if (negative)
+        {
+            value = -value;
+        }
+        return true;
+    }
+
+    bool ok = false;
+    value = text.toString().replace(",", ".").toDouble(&ok);
+    if (!ok)
+    {
+        value = getNaN();
+    }
+    return ok;
+}
+
+QDate CurrencyReplyParser::parseDate(const QStringRef &text)
+{
+    // Формат даты - dd.MM.yyyy
+    const QChar *c = text.constData();
+    if ((text.length() == 10) && (c[2] == QChar('.')) && (c[5] == QChar('.')))
+    {
+        int values[8];
+        static const int positions[8] = {0, 1, 3, 4, 6, 7, 8, 9};
+        bool ok = true;
+        for (int i = 0; (ok) && (i < 8); i++)
+        {
+            ushort u = c[positions[i]].unicode();
+            ok = (u >= '0') && (u <= '9');
+            values[i] = u - '0';
+        }
+        if (ok)
+        {
+            int day = values[0]*10 + values[1];
+            int month = values[2]*10 + values[3];
+            int year = values[4]*1000 + values[5]*100 + values[6]*10 + values[7];
+            return QDate(year, month, day);
+        }
+    }
+    return QDate::fromString(text.toString(), "dd.MM.yyyy");
+}
+
+void CurrencyReplyParser::parse()
+{
+    while (!m_reader.atEnd())
+    {
+        switch (m_reader.readNext())
+        {
+        case QXmlStreamReader::StartElement:
+            m_text.resize(0);
+            startElement();
+            break;
+        case QXmlStreamReader::Characters:
+            // Текст элемента может прийти несколькими частями
+            m_text.append(m_reader.text());
+            break;
+        case QXmlStreamReader::EndElement:
+            endElement();
+            m_text.resize(0);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+
+//******************************************************************************************************
+/*!
+ *\class CurrencyChartReplyParser
+ *\brief Разбор исторических данных (XML_dynamic.asp).
+*/
+//******************************************************************************************************
+
+CurrencyChartReplyParser::CurrencyChartReplyParser()
+    : CurrencyReplyParser()
+    , m_table()
+    , m_row()
+    , m_inRecord(false)
+{
+
+}
+
+const CurrencyChartTable& CurrencyChartReplyParser::table() const
+{
+    return m_table;
+}
+
+void CurrencyChartReplyParser::startElement()
+{
+    if (m_reader.name() == QLatin1String("Record"))
+    {
+        m_inRecord = true;
+        m_row = CurrencyChartRow(parseDate(m_reader.attributes().value(QLatin1String("Date"))), getNaN(), getNaN());
+    }
+}
+
+void CurrencyChartReplyParser::endElement()
+{
+    if (!m_inRecord)
+    {
+        return;
+    }
+    QStringRef name = m_reader.name();
+    if (name == QLatin1String("Value"))
+    {
+        parseDecimal(QStringRef(&m_text), m_row.value);
+    }
+    else if (name == QLatin1String("Nominal"))
+    {
+        parseDecimal(QStringRef(&m_text), m_row.nominal);
+    }
+    else if (name == QLatin1String("Record"))
+    {
+        if (m_row.isValid())
+        {
+            m_table << m_row;
+        }
+        m_inRecord = false;
+    }
+}
+
+
+//******************************************************************************************************
+/*!
+ *\class CurrencyInstrumentReplyParser
+ *\brief Разбор списка валют (XML_val.asp).
+*/
+//******************************************************************************************************
+
+CurrencyInstrumentReplyParser::CurrencyInstrumentReplyParser()
+    : CurrencyReplyParser()
+    , m_instruments()
+    , m_instrument()
+    , m_inItem(false)
+{
+
+}
+
+const QList<CurrencyInstrument>& CurrencyInstrumentReplyParser::instruments() const
+{
+    return m_instruments;
+}
+
+void CurrencyInstrumentReplyParser::startElement()
+{
+    if (m_reader.name() == QLatin1String("Item"))
+    {
+        m_inItem = true;
+        m_instrument = CurrencyInstrument(m_reader.attributes().value(QLatin1String("ID")).toString(), QString());
+    }
+}
+
+void CurrencyInstrumentReplyParser::endElement()
+{
+    if (!m_inItem)
+    {
+        return;
+    }
+    QStringRef name = m_reader.name();
+    if (name == QLatin1String("Name"))
+    {
+        if (m_instrument.name.isEmpty())
+        {
+            m_instrument.name = m_text;
+        }
+    }
+    else if (name == QLatin1String("Item"))
+    {
+        if ((!m_instrument.id.isEmpty()) && (!m_instrument.name.isEmpty()))
+        {
+            m_instruments << m_instrument;
+        }
+        m_inItem = false;
+    }
+}
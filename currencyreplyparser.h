@@ -0,0 +1,62 @@
+#ifndef CURRENCYREPLYPARSER_H
+#define CURRENCYREPLYPARSER_H
+
+#include <QXmlStreamReader>
+#include <QByteArray>
+#include <QString>
+#include "currencyinstrument.h"
+#include "currencycharttable.h"
+
+class CurrencyReplyParser
+{
+public:
+    CurrencyReplyParser();
+    virtual ~CurrencyReplyParser();
+    void addData(const QByteArray &data);
+    bool finish();
+    static bool parseDecimal(const QStringRef &text, double &value);
+    static QDate parseDate(const QStringRef &text);
+
+protected:
+    QXmlStreamReader m_reader;
+    QString m_text;
+    virtual void startElement() = 0;
+    virtual void endElement() = 0;
+
+private:
+    void parse();
+};
+
+class CurrencyChartReplyParser : public CurrencyReplyParser
+{
+public:
+    CurrencyChartReplyParser();
+    const CurrencyChartTable& table() const;
+
+protected:
+    void startElement() override;
+    void endElement() override;
+
+private:
+    CurrencyChartTable m_table;
+    CurrencyChartRow m_row;
+    bool m_inRecord;
+};
+
+class CurrencyInstrumentReplyParser : public CurrencyReplyParser
+{
+public:
+    CurrencyInstrumentReplyParser();
+    const QList<CurrencyInstrument>& instruments() const;
+
+protected:
+    void startElement() override;
+    void endElement() override;
+
+private:
+    QList<CurrencyInstrument> m_instruments;
+    CurrencyInstrument m_instrument;
+    bool m_inItem;
+};
+
+#endif // CURRENCYREPLYPARSER_H
@@ -198,14 +198,14 @@ bool DocumentBox::eventFilter(QObject *object, QEvent *event)
 {
     if (event->type() == QEvent::FocusIn)
     {
-        raise();
+        m_layer->raiseBox(this);
     }
     return QWidget::eventFilter(object, event);
 }
 
 void DocumentBox::focusInEvent(QFocusEvent *)
 {
-    raise();
+    m_layer->raiseBox(this);
 }
 
 void DocumentBox::onWideModeButtonClicked()
@@ -17,7 +17,11 @@ DocumentLayer::DocumentLayer(QWidget *parent)
     ,m_clickPoint()
     ,m_primaryBoxBound(RectBoundTypeNull)
     ,m_boxDrags()
+    ,m_topOrderIndex(0)
+    ,m_indexedBoxes()
+    ,m_boxIndex()
 {
+    m_boxIndex.setBucketSize(m_gridSize*4);
     m_horizontalScale.setGridSize(m_gridSize);
     m_verticalScale.setGridSize(m_gridSize);
 
@@ -59,14 +63,23 @@ QPointF DocumentLayer::roundScreenPoint(const QPointF &point) const
 DocumentBox* DocumentLayer::createBox()
 {
     DocumentBox *result = new DocumentBox(this);
+    result->setOrderIndex(++m_topOrderIndex);
     connect(result, SIGNAL(resizing(RectBoundType,QPoint)), this, SLOT(onBoxResizing(RectBoundType,QPoint)));
     connect(result, SIGNAL(moving(QPoint)), this, SLOT(onBoxMoving(QPoint)));
     connect(result, SIGNAL(wideModeChanging()), this, SLOT(onBoxWideModeChanging()));
     connect(result, SIGNAL(closing()), this, SLOT(onBoxClosing()));
-    result->setStackRect(QRect(0, 0, 1, 1));
-    stackCoordinatesChanged();
-    adjustMinimumSize();
-    buildGridFromStack();
+    if (boxes().count() <= 1)
+    {
+        // Первый документ занимает весь лист
+        result->setStackRect(QRect(0, 0, 1, 1));
+        stackCoordinatesChanged();
+        adjustMinimumSize();
+        buildGridFromStack();
+    }
+    else
+    {
+        placeBox(result);
+    }
     buildScreenFromGrid();
     result->setVisible(true);
     return result;
@@ -77,6 +90,46 @@ DocumentBoxList DocumentLayer::boxes() const
     return findChildren<DocumentBox*>();
 }
 
+void DocumentLayer::arrangeBoxes()
+{
+    DocumentBoxList list = boxes();
+    if (list.isEmpty())
+    {
+        return;
+    }
+
+    // Документы расставляются заново в порядке чтения (сверху вниз, слева направо), сохраняя размеры.
+    // Высота упаковки не ограничена: если документы не помещаются на лист, они пропорционально
+    // сжимаются при пересчёте grid-координат из stack-координат.
+    qStableSort(list.begin(), list.end(), boxGridPositionLessThan);
+    QSize minimumSize = minimumBoxGridSize();
+    int sheetWidth = qMax(m_horizontalScale.gridCount(), minimumSize.width());
+    SkylinePacker packer(sheetWidth, 0);
+    foreach (DocumentBox *box, list)
+    {
+        QRect gridRect = box->gridRect();
+        QSize size(
+                    qBound(minimumSize.width(), gridRect.width(), sheetWidth),
+                    qMax(minimumSize.height(), gridRect.height()));
+        if (packer.insert(size, gridRect))
+        {
+            box->setGridRect(gridRect);
+        }
+    }
+
+    buildStackFromGrid();
+    adjustMinimumSize();
+    buildGridFromStack();
+    buildScreenFromGrid();
+    update();
+}
+
+void DocumentLayer::raiseBox(DocumentBox *box)
+{
+    box->raise();
+    box->setOrderIndex(++m_topOrderIndex);
+}
+
 void DocumentLayer::paintEvent(QPaintEvent *)
 {
     QPainter painter(this);
@@ -230,7 +283,7 @@ void DocumentLayer::onBoxWideModeChanging()
 
     bool isWideMode = !(box->isWideMode());
     box->setWideMode(isWideMode);
-    box->raise();
+    raiseBox(box);
     buildScreenFromGrid();
 }
 
@@ -245,6 +298,7 @@ void DocumentLayer::onBoxClosing()
     box->setVisible(false);
     box->setParent(NULL);
     box->deleteLater();
+    buildBoxIndex();
     stackCoordinatesChanged();
     adjustMinimumSize();
 }
@@ -294,13 +348,45 @@ RectBoundType DocumentLayer::findBound(DocumentBox *box, const QPoint &point) co
     return result;
 }
 
+void DocumentLayer::buildBoxIndex()
+{
+    // Индексируются экранные прямоугольники, расширенные на зону захвата границ и углов
+    int margin = qMax(Design::instance()->size(Design::DocumentBoxBorderSize), Design::instance()->size(Design::DocumentBoxCornerSize));
+    m_indexedBoxes.clear();
+    QVector<QRect> rects;
+    DocumentBoxList list = boxes();
+    foreach (DocumentBox *box, list)
+    {
+        m_indexedBoxes << box;
+        rects << box->screenRect().adjusted(-margin, -margin, margin, margin);
+    }
+    m_boxIndex.build(rects);
+}
+
+DocumentBoxList DocumentLayer::boxesNear(const QPoint &point) const
+{
+    // Коробки, чья зона захвата содержит точку, по убыванию orderIndex, т.е. сверху вниз (коробки поднимаются только через raiseBox())
+    DocumentBoxList result;
+    IntVector indexes = m_boxIndex.itemsAt(point);
+    foreach (int index, indexes)
+    {
+        DocumentBox *box = m_indexedBoxes[index].data();
+        if ((box != NULL) && (box->parent() == this))
+        {
+            result << box;
+        }
+    }
+    qSort(result.begin(), result.end(), boxOrderIndexGreaterThan);
+    return result;
+}
+
 void DocumentLayer::computeBound(const QPoint &point, DocumentBoxPtr &box, RectBoundType &bound) const
 {
     box = NULL;
     bound = RectBoundTypeNull;
 
-    DocumentBoxList list = boxes();
-    for (int i = list.count()-1; i >= 0; i--)
+    DocumentBoxList list = boxesNear(point);
+    for (int i = 0; i < list.count(); i++)
     {
         RectBoundType currentBound = findBound(list[i], point);
         if (currentBound != RectBoundTypeNull)
@@ -321,8 +407,8 @@ void DocumentLayer::buildBoxDrags(const QPoint &point)
     int firstBoxIndex = -1;
     RectBoundType firstBoundType = RectBoundTypeNull;
 
-    DocumentBoxList list = boxes();
-    for (int i = list.count()-1; i >= 0; i--)
+    DocumentBoxList list = boxesNear(point);
+    for (int i = 0; i < list.count(); i++)
     {
         RectBoundType boundType = findBound(list[i], point);
         if (boundType != RectBoundTypeNull)
@@ -490,6 +576,7 @@ void DocumentLayer::buildScreenFromGrid()
             box->setGeometry(geometryRect);
         }
     }
+    buildBoxIndex();
 }
 
 QSize DocumentLayer::minimumBoxGridSize() const
@@ -535,6 +622,76 @@ DocumentBox* DocumentLayer::widenedBox() const
     return result;
 }
 
+void DocumentLayer::placeBox(DocumentBox *box)
+{
+    QSize minimumSize = minimumBoxGridSize();
+
+    // Ищем свободное место под уже расставленными документами
+    SkylinePacker packer(m_horizontalScale.gridCount(), m_verticalScale.gridCount());
+    DocumentBox *largestBox = NULL;
+    int largestArea = 0;
+    DocumentBoxList list = boxes();
+    foreach (DocumentBox *other, list)
+    {
+        if (other == box)
+        {
+            continue;
+        }
+        QRect otherRect = other->gridRect();
+        packer.occupy(otherRect);
+        int area = otherRect.width() * otherRect.height();
+        if ((largestBox == NULL) || (largestArea < area))
+        {
+            largestBox = other;
+            largestArea = area;
+        }
+    }
+
+    QRect gridRect;
+    if (packer.insert(minimumSize, gridRect))
+    {
+        box->setGridRect(gridRect);
+    }
+    else if ((largestBox != NULL) && (splitBox(largestBox, gridRect)))
+    {
+        // Места нет - делим пополам наибольший документ
+        box->setGridRect(gridRect);
+    }
+    else
+    {
+        // Делить нечего - расставляем все документы заново
+        box->setGridRect(QRect(QPoint(0, 0), minimumSize));
+        arrangeBoxes();
+        return;
+    }
+    buildStackFromGrid();
+    adjustMinimumSize();
+}
+
+bool DocumentLayer::splitBox(DocumentBox *box, QRect &freedGridRect) const
+{
+    // Делим по длинной стороне; левая (верхняя) половина остаётся документу, правая (нижняя) освобождается
+    QSize minimumSize = minimumBoxGridSize();
+    QRect gridRect = box->gridRect();
+    bool canSplitWidth = (gridRect.width() / 2 >= minimumSize.width());
+    bool canSplitHeight = (gridRect.height() / 2 >= minimumSize.height());
+    if ((canSplitWidth) && ((gridRect.width() >= gridRect.height()) || (!canSplitHeight)))
+    {
+        int width = gridRect.width() / 2;
+        freedGridRect = QRect(gridRect.left() + width, gridRect.top(), gridRect.width() - width, gridRect.height());
+        box->setGridRect(QRect(gridRect.left(), gridRect.top(), width, gridRect.height()));
+        return true;
+    }
+    if (canSplitHeight)
+    {
+        int height = gridRect.height() / 2;
+        freedGridRect = QRect(gridRect.left(), gridRect.top() + height, gridRect.width(), gridRect.height() - height);
+        box->setGridRect(QRect(gridRect.left(), gridRect.top(), gridRect.width(), height));
+        return true;
+    }
+    return false;
+}
+
 void DocumentLayer::computeOccupiedTargetCoordinates(double occupiedStackCoordinate1,
         double occupiedStackCoordinate2,
         double minimalTargetSize,
@@ -576,3 +733,15 @@ QRectF DocumentLayer::transform(const QRectF &p, const QRectF &s, const QRectF &
     QPointF bottomRight(transform(p.bottomRight(), s, d));
     return QRectF(topLeft, bottomRight);
 }
+
+bool DocumentLayer::boxGridPositionLessThan(DocumentBox *box1, DocumentBox *box2)
+{
+    QRect r1 = box1->gridRect();
+    QRect r2 = box2->gridRect();
+    return (r1.top() < r2.top()) || ((r1.top() == r2.top()) && (r1.left() < r2.left()));
+}
+
+bool DocumentLayer::boxOrderIndexGreaterThan(DocumentBox *box1, DocumentBox *box2)
+{
+    return (box1->orderIndex() > box2->orderIndex());
+}
@@ -7,6 +7,8 @@
 #include "placeroutine.h"
 #include "documentbox.h"
 #include "gridcoordinategenerator.h"
+#include "skylinepacker.h"
+#include "gridbucketindex.h"
 
 class DocumentLayer : public QWidget
 {
@@ -22,6 +24,8 @@ public:
     QPointF roundScreenPoint(const QPointF &point) const;
     DocumentBox* createBox();
     DocumentBoxList boxes() const;
+    void arrangeBoxes();
+    void raiseBox(DocumentBox *box);
 
 protected:
     void paintEvent(QPaintEvent *event) override;
@@ -46,10 +50,15 @@ private:
     QPoint m_clickPoint;
     RectBoundType m_primaryBoxBound;
     QHash<DocumentBoxPtr, RectBoundType> m_boxDrags;
+    int m_topOrderIndex;
+    QList<DocumentBoxPtr> m_indexedBoxes;
+    GridBucketIndex m_boxIndex;
 
     QRectF computeOccupiedStackRect() const;
     QRect computeOccupiedGridRect() const;
     RectBoundType findBound(DocumentBox *box, const QPoint &point) const;
+    void buildBoxIndex();
+    DocumentBoxList boxesNear(const QPoint &point) const;
     void computeBound(const QPoint &point, DocumentBoxPtr &box, RectBoundType &bound) const;
     void buildBoxDrags(const QPoint &point);
     void adjustMinimumSize();
@@ -62,6 +71,8 @@ private:
     QSize computeMinimumGridSize() const;
     void stackCoordinatesChanged();
     DocumentBox* widenedBox() const;
+    void placeBox(DocumentBox *box);
+    bool splitBox(DocumentBox *box, QRect &freedGridRect) const;
 
     static void computeOccupiedTargetCoordinates(
             double occupiedStackCoordinate1,
@@ -72,6 +83,8 @@ private:
             double &occupiedTargetCoordinate2);
     static QPointF transform(const QPointF &p, const QRectF &s, const QRectF &d);
     static QRectF transform(const QRectF &p, const QRectF &s, const QRectF &d);
+    static bool boxGridPositionLessThan(DocumentBox *box1, DocumentBox *box2);
+    static bool boxOrderIndexGreaterThan(DocumentBox *box1, DocumentBox *box2);
 };
 
 #endif // DOCUMENTLAYER_H
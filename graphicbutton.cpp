@@ -205,11 +205,11 @@ void GraphicButton::paint(QPainter *painter)
     }
 }
 
-void GraphicButton::handleEvent(UserEvent event)
+bool GraphicButton::handleEvent(UserEvent event)
 {
     if (!isEnabled())
     {
-        return;
+        return false;
     }
     if (event.type == UserEvent::MouseDown)
     {
@@ -251,6 +251,7 @@ void GraphicButton::handleEvent(UserEvent event)
     {
         setCurrentState(StateNormal);
     }
+    return (event.type != UserEvent::MouseWheel);
 }
 
 HitInfo GraphicButton::hitInfo(const QPointF &point) const
@@ -50,7 +50,7 @@ public:
     bool isDown() const;
     QSizeF sizeConstraint(const QSizeF &supposedSize) const override;
     void paint(QPainter *painter) override;
-    void handleEvent(UserEvent event) override;
+    bool handleEvent(UserEvent event) override;
     HitInfo hitInfo(const QPointF &point) const override;
 
 signals:
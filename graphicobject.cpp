@@ -14,6 +14,7 @@ UserEvent::UserEvent()
      button(Qt::NoButton),
      buttons(Qt::NoButton),
      mousePosition(0, 0),
+     wheelDelta(0),
      key(0)
 {
 
@@ -39,6 +40,9 @@ QString UserEvent::toString() const
     case MouseDoubleClick:
         result = QString("MouseDoubleClick (%1, %2)").arg(mousePosition.x()).arg(mousePosition.y());
         break;
+    case MouseWheel:
+        result = QString("MouseWheel %1, (%2, %3)").arg(wheelDelta).arg(mousePosition.x()).arg(mousePosition.y());
+        break;
     case KeyPress:
         result = QString("KeyPress, %1").arg(key);
         break;
@@ -351,9 +355,9 @@ HitInfo GraphicObject::hitInfo(const QPointF &point) const
     return result;
 }
 
-void GraphicObject::handleEvent(UserEvent event)
+bool GraphicObject::handleEvent(UserEvent event)
 {
-    handleEventByChildrenObjects(event);
+    return handleEventByChildrenObjects(event);
 }
 
 QSizeF GraphicObject::sizeConstraint(const QSizeF &) const
@@ -369,6 +373,14 @@ void GraphicObject::redraw()
     }
 }
 
+void GraphicObject::redrawRect(const QRectF &rect)
+{
+    if (m_supervisor != NULL)
+    {
+        m_supervisor->redrawRect(rect);
+    }
+}
+
 void GraphicObject::updateAndRedraw()
 {
     if (m_supervisor != NULL)
@@ -423,8 +435,10 @@ GraphicObject* GraphicObject::findHitChildObject(const QPointF &point, HitInfo &
     return result;
 }
 
-void GraphicObject::handleEventByChildrenObjects(UserEvent event)
+bool GraphicObject::handleEventByChildrenObjects(UserEvent event)
 {
+    // Возвращает, использовал ли событие кто-то из дочерних объектов
+    bool result = false;
     if (event.type == UserEvent::MouseLeave)
     {
         sendMouseLeaveMessage(m_lastSendedChild);
@@ -432,25 +446,27 @@ void GraphicObject::handleEventByChildrenObjects(UserEvent event)
     }
     if ((event.type == UserEvent::KeyPress) || (event.type == UserEvent::KeyRelease))
     {
-        sendKeyMessage(event);
+        result = sendKeyMessage(event);
     }
     if ((event.type == UserEvent::MouseDown) ||
         (event.type == UserEvent::MouseUp) ||
         (event.type == UserEvent::MouseMove) ||
-        (event.type == UserEvent::MouseDoubleClick))
+        (event.type == UserEvent::MouseDoubleClick) ||
+        (event.type == UserEvent::MouseWheel))
     {
         GraphicObject *handleUsingChild = findHandleUsingChildObject();
         if (handleUsingChild)
         {
-            sendMouseMessage(handleUsingChild, event);
+            result = sendMouseMessage(handleUsingChild, event);
         }
         else
         {
             HitInfo hitInfo;
             GraphicObject *childObject = findHitChildObject(event.mousePosition, hitInfo);
-            sendMouseMessage(childObject, event);
+            result = sendMouseMessage(childObject, event);
         }
     }
+    return result;
 }
 
 QString GraphicObject::wrapHintToHtml(const QString &text)
@@ -499,19 +515,22 @@ void GraphicObject::sendMouseLeaveMessage(GraphicObject *obj)
     }
 }
 
-void GraphicObject::sendKeyMessage(UserEvent event)
+bool GraphicObject::sendKeyMessage(UserEvent event)
 {
+    bool result = false;
     foreach (GraphicObject *obj, m_childrenObjects)
     {
         if ((obj->visible()) && (obj->handleUsing()))
         {
-            obj->handleEvent(event);
+            result = obj->handleEvent(event) || result;
         }
     }
+    return result;
 }
 
-void GraphicObject::sendMouseMessage(GraphicObject *obj, UserEvent event)
+bool GraphicObject::sendMouseMessage(GraphicObject *obj, UserEvent event)
 {
+    bool result = false;
     if (obj)
     {
         if (obj != m_lastSendedChild)
@@ -519,7 +538,7 @@ void GraphicObject::sendMouseMessage(GraphicObject *obj, UserEvent event)
             sendMouseLeaveMessage(m_lastSendedChild);
         }
         m_lastSendedChild = obj;
-        obj->handleEvent(event);
+        result = obj->handleEvent(event);
     }
     else
     {
@@ -527,6 +546,7 @@ void GraphicObject::sendMouseMessage(GraphicObject *obj, UserEvent event)
         m_lastSendedChild = NULL;
         sendMouseLeaveMessage(sendTo);
     }
+    return result;
 }
 
 bool GraphicObject::drawIndexLessThan(GraphicObject *obj1, GraphicObject *obj2)
@@ -17,6 +17,7 @@ class AbstractGraphicSupervisor
 {
 public:
     virtual void redraw() = 0;
+    virtual void redrawRect(const QRectF &rect) = 0;
     virtual void updateAndRedraw() = 0;
     virtual QPointF positionFromLocalToGlobal(const QPointF &p) = 0;
     virtual QPointF positionFromGlobalToLocal(const QPointF &p) = 0;
@@ -32,6 +33,7 @@ struct UserEvent
         MouseMove,
         MouseLeave,
         MouseDoubleClick,
+        MouseWheel,
         KeyPress,
         KeyRelease
     };
@@ -39,6 +41,7 @@ struct UserEvent
     Qt::MouseButton button;
     Qt::MouseButtons buttons;
     QPoint mousePosition;
+    int wheelDelta;
     int key;
     UserEvent();
     QString toString() const;
@@ -90,8 +93,9 @@ public:
     virtual void resize();
     virtual void update();
     virtual HitInfo hitInfo(const QPointF &point) const;
-    virtual void handleEvent(UserEvent event);
+    virtual bool handleEvent(UserEvent event);
     void redraw();
+    void redrawRect(const QRectF &rect);
     void updateAndRedraw();
 
 protected:
@@ -99,7 +103,7 @@ protected:
     void setRectToChildrenObjects(const QRectF &rect);
     void updateChildrenObjects();
     GraphicObject* findHitChildObject(const QPointF &point, HitInfo &hitInfo) const;
-    void handleEventByChildrenObjects(UserEvent event);
+    bool handleEventByChildrenObjects(UserEvent event);
     static QString wrapHintToHtml(const QString &text);
 
 private:
@@ -115,8 +119,8 @@ private:
     void assignOrderIndexes();
     GraphicObject* findHandleUsingChildObject() const;
     void sendMouseLeaveMessage(GraphicObject *obj);
-    void sendKeyMessage(UserEvent event);
-    void sendMouseMessage(GraphicObject *obj, UserEvent event);
+    bool sendKeyMessage(UserEvent event);
+    bool sendMouseMessage(GraphicObject *obj, UserEvent event);
     static bool drawIndexLessThan(GraphicObject *obj1, GraphicObject *obj2);
     static bool drawIndexGreaterThan(GraphicObject *obj1, GraphicObject *obj2);
     static bool handleIndexLessThan(GraphicObject *obj1, GraphicObject *obj2);
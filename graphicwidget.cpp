@@ -1,6 +1,7 @@
 #include "graphicwidget.h"
 #include <QPainter>
 #include <QMouseEvent>
+#include <QWheelEvent>
 #include "hintwindow.h"
 
 #include <QDebug>
@@ -52,6 +53,12 @@ void GraphicWidget::redraw()
     update();
 }
 
+void GraphicWidget::redrawRect(const QRectF &rect)
+{
+    // Перерисовка части виджета; запас в пиксель - на сглаживание
+    update(rect.toAlignedRect().adjusted(-1, -1, 1, 1));
+}
+
 void GraphicWidget::updateAndRedraw()
 {
     if ((m_graphicObject != NULL))
@@ -204,6 +211,33 @@ void GraphicWidget::mouseDoubleClickEvent(QMouseEvent *event)
     }
 }
 
+void GraphicWidget::wheelEvent(QWheelEvent *event)
+{
+    // Неиспользованное колесо уходит родителю - например, прокручивает Sheet
+    bool used = false;
+    if (processEvents())
+    {
+        UserEvent ue;
+        ue.type = UserEvent::MouseWheel;
+        ue.buttons = event->buttons();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        ue.mousePosition = event->position().toPoint();
+#else
+        ue.mousePosition = event->pos();
+#endif
+        ue.wheelDelta = event->angleDelta().y();
+        used = graphicObject()->handleEvent(ue);
+    }
+    if (used)
+    {
+        event->accept();
+    }
+    else
+    {
+        event->ignore();
+    }
+}
+
 void GraphicWidget::keyPressEvent(QKeyEvent *event)
 {
     emit keyPressed(event);
@@ -16,6 +16,7 @@ public:
     void setGraphicObject(GraphicObject *value);
     GraphicObject* graphicObject() const;
     void redraw() override;
+    void redrawRect(const QRectF &rect) override;
     void updateAndRedraw() override;
     QPointF positionFromLocalToGlobal(const QPointF &p) override;
     QPointF positionFromGlobalToLocal(const QPointF &p) override;
@@ -36,6 +37,7 @@ protected:
     void mouseMoveEvent(QMouseEvent *event) override;
     void leaveEvent(QEvent *event) override;
     void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
     void keyReleaseEvent(QKeyEvent *event) override;
     void hideEvent(QHideEvent *event) override;
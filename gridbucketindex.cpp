@@ -0,0 +1,138 @@
+#include "gridbucketindex.h"
+
+//******************************************************************************************************
+/*!
+ *\class GridBucketIndex
+ *\brief Пространственный индекс прямоугольников: область, занятая прямоугольниками, делится на
+ * квадратные ячейки (bucket), и для каждой ячейки хранятся номера пересекающих её прямоугольников.
+ * Поиск по точке просматривает только одну ячейку.
+*/
+//******************************************************************************************************
+
+GridBucketIndex::GridBucketIndex()
+    :m_bucketSize(64)
+    ,m_rects()
+    ,m_bounds()
+    ,m_columnCount(0)
+    ,m_rowCount(0)
+    ,m_bucketOffsets()
+    ,m_bucketItems()
+{
+}
+
+void GridBucketIndex::setBucketSize(int value)
+{
+    m_bucketSize = qMax(value, 1);
+}
+
+int GridBucketIndex::bucketSize() const
+{
+    return m_bucketSize;
+}
+
+void GridBucketIndex::clear()
+{
+    m_rects.clear();
+    m_bounds = QRect();
+    m_columnCount = 0;
+    m_rowCount = 0;
+    m_bucketOffsets.clear();
+    m_bucketItems.clear();
+}
+
+void GridBucketIndex::build(const QVector<QRect> &rects)
+{
+    clear();
+    m_rects = rects;
+    foreach (const QRect &r, m_rects)
+    {
+        if (!r.isEmpty())
+        {
+            m_bounds = m_bounds.united(r);
+        }
+    }
+    if (m_bounds.isEmpty())
+    {
+        return;
+    }
+    m_columnCount = (m_bounds.width() + m_bucketSize - 1) / m_bucketSize;
+    m_rowCount = (m_bounds.height() + m_bucketSize - 1) / m_bucketSize;
+
+    // Подсчёт числа прямоугольников в каждой ячейке, затем раскладка номеров (в порядке возрастания)
+    m_bucketOffsets.fill(0, m_columnCount*m_rowCount + 1);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        IntVector positions;
+        if (pass == 1)
+        {
+            for (int i = 0; i < m_columnCount*m_rowCount; i++)
+            {
+                m_bucketOffsets[i+1] += m_bucketOffsets[i];
+            }
+            m_bucketItems.fill(-1, m_bucketOffsets.last());
+            positions = m_bucketOffsets;
+        }
+        for (int index = 0; index < m_rects.count(); index++)
+        {
+            const QRect &r = m_rects[index];
+            if (r.isEmpty())
+            {
+                continue;
+            }
+            for (int row = bucketRow(r.top()); row <= bucketRow(r.bottom()); row++)
+            {
+                for (int column = bucketColumn(r.left()); column <= bucketColumn(r.right()); column++)
+                {
+                    int bucket = row*m_columnCount + column;
+                    if (pass == 0)
+                    {
+                        m_bucketOffsets[bucket+1]++;
+                    }
+                    else
+                    {
+                        m_bucketItems[positions[bucket]++] = index;
+                    }
+                }
+            }
+        }
+    }
+}
+
+int GridBucketIndex::count() const
+{
+    return m_rects.count();
+}
+
+QRect GridBucketIndex::rect(int index) const
+{
+    return m_rects[index];
+}
+
+IntVector GridBucketIndex::itemsAt(const QPoint &point) const
+{
+    IntVector result;
+    if (!m_bounds.contains(point))
+    {
+        return result;
+    }
+    int bucket = bucketRow(point.y())*m_columnCount + bucketColumn(point.x());
+    for (int i = m_bucketOffsets[bucket]; i < m_bucketOffsets[bucket+1]; i++)
+    {
+        int index = m_bucketItems[i];
+        if (m_rects[index].contains(point))
+        {
+            result << index;
+        }
+    }
+    return result;
+}
+
+int GridBucketIndex::bucketColumn(int x) const
+{
+    return qBound(0, (x - m_bounds.left()) / m_bucketSize, m_columnCount - 1);
+}
+
+int GridBucketIndex::bucketRow(int y) const
+{
+    return qBound(0, (y - m_bounds.top()) / m_bucketSize, m_rowCount - 1);
+}
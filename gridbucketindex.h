@@ -0,0 +1,32 @@
+#ifndef GRIDBUCKETINDEX_H
+#define GRIDBUCKETINDEX_H
+
+#include <QRect>
+#include <QPoint>
+#include "base.h"
+
+class GridBucketIndex
+{
+public:
+    GridBucketIndex();
+    void setBucketSize(int value);
+    int bucketSize() const;
+    void clear();
+    void build(const QVector<QRect> &rects);
+    int count() const;
+    QRect rect(int index) const;
+    IntVector itemsAt(const QPoint &point) const;
+
+private:
+    int m_bucketSize;
+    QVector<QRect> m_rects;
+    QRect m_bounds;
+    int m_columnCount;
+    int m_rowCount;
+    IntVector m_bucketOffsets;
+    IntVector m_bucketItems;
+    int bucketColumn(int x) const;
+    int bucketRow(int y) const;
+};
+
+#endif // GRIDBUCKETINDEX_H
@@ -109,6 +109,194 @@ bool GridSegment::operator!=(const GridSegment &other) const
 }
 
 
+//******************************************************************************************************
+/*!
+ *\struct GridBearingPath
+ *\brief Опорный путь, найденный для вершины vertex, и диапазон вершин [spanMin, spanMax], от рёбер
+ * и grid-координат которых зависел результат поиска.
+*/
+//******************************************************************************************************
+
+GridBearingPath::GridBearingPath()
+    :vertex(-1)
+    ,spanMin(-1)
+    ,spanMax(-1)
+    ,path()
+{
+
+}
+
+
+//******************************************************************************************************
+/*!
+ *\class GridGraph
+ *\brief Граф вершин в сжатом виде (CSR): для каждой вершины хранятся только исходящие рёбра к вершинам
+ * с большими номерами, упорядоченные по номеру целевой вершины.
+*/
+//******************************************************************************************************
+
+GridGraph::GridGraph()
+    :m_offsets()
+    ,m_targets()
+    ,m_constraintCounts()
+    ,m_firstSources()
+{
+}
+
+void GridGraph::clear()
+{
+    m_offsets.clear();
+    m_targets.clear();
+    m_constraintCounts.clear();
+    m_firstSources.clear();
+}
+
+void GridGraph::build(int vertexCount, const IntVector &segmentVertexes)
+{
+    clear();
+    if (vertexCount <= 0)
+    {
+        return;
+    }
+
+    // Количество рёбер, исходящих из каждой вершины: к соседней вершине и к концам отрезков
+    m_offsets.fill(0, vertexCount + 1);
+    for (int vertex = 0; vertex < vertexCount-1; vertex++)
+    {
+        m_offsets[vertex+1]++;
+    }
+    for (int i = 0; i+1 < segmentVertexes.count(); i += 2)
+    {
+        int vertex1 = qMin(segmentVertexes[i], segmentVertexes[i+1]);
+        int vertex2 = qMax(segmentVertexes[i], segmentVertexes[i+1]);
+        if (vertex1 < vertex2)
+        {
+            m_offsets[vertex1+1]++;
+        }
+    }
+    for (int vertex = 0; vertex < vertexCount; vertex++)
+    {
+        m_offsets[vertex+1] += m_offsets[vertex];
+    }
+
+    // Размещение рёбер; ребро кодируется как target*2 + (количество ограничений по дистанции)
+    IntVector keys(m_offsets.last(), 0);
+    IntVector positions = m_offsets;
+    for (int vertex = 0; vertex < vertexCount-1; vertex++)
+    {
+        keys[positions[vertex]++] = (vertex+1)*2;   // 0 вершины связаны между собой, но не ограничены по дистанции
+    }
+    for (int i = 0; i+1 < segmentVertexes.count(); i += 2)
+    {
+        int vertex1 = qMin(segmentVertexes[i], segmentVertexes[i+1]);
+        int vertex2 = qMax(segmentVertexes[i], segmentVertexes[i+1]);
+        if (vertex1 < vertex2)
+        {
+            keys[positions[vertex1]++] = vertex2*2 + 1;    // 1 вершины имеют ограничение по дистанции
+        }
+    }
+
+    // Упорядочивание рёбер каждой вершины и слияние совпадающих (ограничения по дистанции суммируются)
+    m_targets.resize(keys.count());
+    m_constraintCounts.resize(keys.count());
+    int count = 0;
+    for (int vertex = 0; vertex < vertexCount; vertex++)
+    {
+        int begin = m_offsets[vertex];
+        int end = m_offsets[vertex+1];
+        m_offsets[vertex] = count;
+        qSort(keys.begin() + begin, keys.begin() + end);
+        for (int i = begin; i < end; i++)
+        {
+            int target = keys[i] / 2;
+            int constraints = keys[i] % 2;
+            if ((count > m_offsets[vertex]) && (m_targets[count-1] == target))
+            {
+                m_constraintCounts[count-1] += constraints;
+            }
+            else
+            {
+                m_targets[count] = target;
+                m_constraintCounts[count] = constraints;
+                count++;
+            }
+        }
+    }
+    m_offsets[vertexCount] = count;
+    m_targets.resize(count);
+    m_constraintCounts.resize(count);
+
+    // Вершина с наименьшим номером, из которой есть ребро в данную
+    m_firstSources.fill(-1, vertexCount);
+    for (int vertex = vertexCount-1; vertex >= 0; vertex--)
+    {
+        for (int edge = firstEdge(vertex); edge < lastEdge(vertex); edge++)
+        {
+            m_firstSources[m_targets[edge]] = vertex;
+        }
+    }
+}
+
+int GridGraph::vertexCount() const
+{
+    return qMax(m_offsets.count() - 1, 0);
+}
+
+int GridGraph::edgeCount() const
+{
+    return m_targets.count();
+}
+
+int GridGraph::firstEdge(int vertex) const
+{
+    return m_offsets[vertex];
+}
+
+int GridGraph::lastEdge(int vertex) const
+{
+    return m_offsets[vertex+1];
+}
+
+int GridGraph::edgeTarget(int edge) const
+{
+    return m_targets[edge];
+}
+
+int GridGraph::edgeWeight(int edge) const
+{
+    return (m_constraintCounts[edge] > 0) ? 1 : 0;
+}
+
+int GridGraph::weight(int vertex1, int vertex2) const
+{
+    // -1 нет связи между вершинами
+    int edge = findEdge(vertex1, vertex2);
+    return (edge >= 0) ? edgeWeight(edge) : -1;
+}
+
+int GridGraph::firstSource(int vertex) const
+{
+    // -1 в вершину не ведёт ни одно ребро
+    return m_firstSources[vertex];
+}
+
+int GridGraph::findEdge(int vertex1, int vertex2) const
+{
+    if ((vertex1 < 0) || (vertex1 >= vertexCount()))
+    {
+        return -1;
+    }
+    IntVector::const_iterator begin = m_targets.constBegin() + firstEdge(vertex1);
+    IntVector::const_iterator end = m_targets.constBegin() + lastEdge(vertex1);
+    IntVector::const_iterator iter = qLowerBound(begin, end, vertex2);
+    if ((iter != end) && (*iter == vertex2))
+    {
+        return iter - m_targets.constBegin();
+    }
+    return -1;
+}
+
+
 //******************************************************************************************************
 /*!
  *\class GridCoordinateGenerator
@@ -123,11 +311,12 @@ GridCoordinateGenerator::GridCoordinateGenerator()
     ,m_gridSegmentList()
     ,m_vertexIndexes()
     ,m_stackCoordinates()
-    ,m_adjacencyMatrix()
-    ,m_paths()
+    ,m_sortedStackIndexes()
+    ,m_graph()
     ,m_maxPathLength(0)
     ,m_longestPath()
     ,m_gridCoordinates()
+    ,m_bearingPaths()
 {
 }
 
@@ -136,8 +325,12 @@ void GridCoordinateGenerator::setMinimalSegmentGridLength(int value)
     int correctedValue = qMax(value, 1);
     if (m_minimalSegmentGridLength != correctedValue)
     {
+        // Граф от минимальной длины не зависит
+        GridCoordinateGenerator previous(*this);
         m_minimalSegmentGridLength = correctedValue;
-        computeAll();
+        computeGridSpace();
+        computeGridCoordinates(previous);
+        computeGridSegmentList();
     }
 }
 
@@ -148,13 +341,55 @@ int GridCoordinateGenerator::minimalSegmentGridLength() const
 
 void GridCoordinateGenerator::setStackSegmentList(const StackSegmentList &value)
 {
-    if (m_stackSegmentList != value)
+    if (m_stackSegmentList.count() == value.count())
+    {
+        // Если изменился ровно один отрезок, пересчитываем инкрементально
+        int changedIndex = -1;
+        int changedCount = 0;
+        for (int i = 0; (i < value.count()) && (changedCount < 2); i++)
+        {
+            if (m_stackSegmentList[i] != value[i])
+            {
+                changedIndex = i;
+                changedCount++;
+            }
+        }
+        if (changedCount == 1)
+        {
+            setStackSegment(changedIndex, value[changedIndex]);
+        }
+        else if (changedCount > 1)
+        {
+            m_stackSegmentList = value;
+            computeAll();
+        }
+    }
+    else
     {
         m_stackSegmentList = value;
         computeAll();
     }
 }
 
+void GridCoordinateGenerator::setStackSegment(int index, const StackSegment &value)
+{
+    if ((index < 0) || (index >= m_stackSegmentList.count()) || (m_stackSegmentList[index] == value))
+    {
+        return;
+    }
+
+    // Вершины и граф перестраиваются линейно (без сортировки), опорные пути - только там,
+    // где их затронуло изменение
+    m_stackSegmentList[index] = value;
+    GridCoordinateGenerator previous(*this);
+    updateVertexes(index);
+    buildGraph();
+    computeLongestPath();
+    computeGridSpace();
+    computeGridCoordinates(previous);
+    computeGridSegmentList();
+}
+
 StackSegmentList GridCoordinateGenerator::stackSegmentList() const
 {
     return m_stackSegmentList;
@@ -170,8 +405,9 @@ void GridCoordinateGenerator::setSupposedGridSpace(const GridSegment &value)
     if (m_supposedGridSpace != value)
     {
         m_supposedGridSpace = value;
+        GridCoordinateGenerator previous(*this);
         computeGridSpace();
-        computeGridCoordinates();
+        computeGridCoordinates(previous);
         computeGridSegmentList();
     }
 }
@@ -215,11 +451,11 @@ QStringList GridCoordinateGenerator::debugInformation() const
     for (int i = 0; i < m_stackCoordinates.count(); i++)
     {
         QStringList toSt;
-        for (int j = i + 1; j < m_stackCoordinates.count(); j++)
+        for (int edge = m_graph.firstEdge(i); edge < m_graph.lastEdge(i); edge++)
         {
-            if (m_adjacencyMatrix[i][j] >= 1)
+            if (m_graph.edgeWeight(edge) >= 1)
             {
-                toSt << QString::number(j);
+                toSt << QString::number(m_graph.edgeTarget(edge));
             }
         }
         if (toSt.isEmpty())
@@ -233,19 +469,12 @@ QStringList GridCoordinateGenerator::debugInformation() const
     }
     result << QString("Adjacencies: (%1)").arg(adjacenciesSt.join(", "));
 
-    QStringList pathSt;
-    foreach (const IntVector &path, m_paths)
+    QStringList longestPathSt;
+    foreach (int index, m_longestPath)
     {
-        QStringList vs;
-        foreach (int index, path)
-        {
-            vs << QString::number(index);
-        }
-        pathSt << QString("<%1>").arg(vs.join(" "));
+        longestPathSt << QString::number(index);
     }
-    result << "*** paths";
-    result << pathSt;
-    result << "*** end paths";
+    result << QString("Longest path: <%1>").arg(longestPathSt.join(" "));
 
     result << QString("Max path length: %1").arg(m_maxPathLength);
     result << QString("Grid space: [%1, %2]").arg(m_gridSpace.min).arg(m_gridSpace.max);
@@ -269,89 +498,72 @@ public:
     }
 };
 
-void GridCoordinateGenerator::buildVertexes()
+DoubleVector GridCoordinateGenerator::rawStackCoordinates() const
 {
-    DoubleVector stackCoordinates;
+    DoubleVector result;
+    result.reserve(m_stackSegmentList.count()*2);
     for (int i = 0; i < m_stackSegmentList.count(); i++)
     {
-        stackCoordinates << m_stackSegmentList[i].min;
-        stackCoordinates << m_stackSegmentList[i].max;
+        result << m_stackSegmentList[i].min;
+        result << m_stackSegmentList[i].max;
     }
+    return result;
+}
+
+void GridCoordinateGenerator::buildVertexes()
+{
+    DoubleVector stackCoordinates = rawStackCoordinates();
 
     CoordinateIndexSortHelper sorter;
     sorter.setBaseVector(stackCoordinates);
     qSort(sorter.indexes().begin(), sorter.indexes().end(), sorter);
+    m_sortedStackIndexes = sorter.indexes();
 
     m_stackCoordinates.clear();
     m_vertexIndexes.clear();
-    reduceStackCoordinates(stackCoordinates, sorter.indexes(), m_stackCoordinates, m_vertexIndexes);
+    reduceStackCoordinates(stackCoordinates, m_sortedStackIndexes, m_stackCoordinates, m_vertexIndexes);
 }
 
-void GridCoordinateGenerator::buildAdjacencyMatrix()
+void GridCoordinateGenerator::updateVertexes(int index)
 {
-    // Начальное заполнение
-    m_adjacencyMatrix.clear();
-    for (int i = 0; i < m_stackCoordinates.count(); i++)
+    // Упорядоченность концов отрезков поддерживается на месте: концы изменившегося отрезка
+    // переставляются двоичным поиском, после чего вершины заново сливаются одним проходом
+    DoubleVector stackCoordinates = rawStackCoordinates();
+    m_sortedStackIndexes.remove(m_sortedStackIndexes.indexOf(index*2));
+    m_sortedStackIndexes.remove(m_sortedStackIndexes.indexOf(index*2 + 1));
+    for (int end = index*2; end <= index*2 + 1; end++)
     {
-        IntVector row;
-        row.fill(-1, m_stackCoordinates.count());    // -1 нет связи между вершинами
-        if (i > 0)
+        int position = 0;
+        int count = m_sortedStackIndexes.count();
+        while (count > 0)
         {
-            row[i-1] = 0;   // 0 вершины связаны между собой, но не ограничены по дистанции
-        }
-        if (i < m_stackCoordinates.count()-1)
-        {
-            row[i+1] = 0;
+            int half = count / 2;
+            if (stackCoordinates[m_sortedStackIndexes[position + half]] < stackCoordinates[end])
+            {
+                position += half + 1;
+                count -= half + 1;
+            }
+            else
+            {
+                count = half;
+            }
         }
-        m_adjacencyMatrix << row;
+        m_sortedStackIndexes.insert(position, end);
     }
 
-    // Заполнение ограничениями по дистанции
-    for (int i = 0; i < m_stackSegmentList.count(); i++)
-    {
-        int vertex1 = m_vertexIndexes[i*2];
-        int vertex2 = m_vertexIndexes[i*2 + 1];
-        m_adjacencyMatrix[vertex1][vertex2] = 1;    // 1 вершины имеют ограничение по дистанции
-        m_adjacencyMatrix[vertex2][vertex1] = 1;
-    }
+    m_stackCoordinates.clear();
+    reduceStackCoordinates(stackCoordinates, m_sortedStackIndexes, m_stackCoordinates, m_vertexIndexes);
 }
 
-void GridCoordinateGenerator::computeGraph()
+void GridCoordinateGenerator::buildGraph()
 {
-    buildVertexes();
-    buildAdjacencyMatrix();
+    m_graph.build(m_stackCoordinates.count(), m_vertexIndexes);
 }
 
-IntVectorList GridCoordinateGenerator::pathsFrom(int vertex) const
+void GridCoordinateGenerator::computeGraph()
 {
-    IntVectorList result;
-
-    // Путь, состоящий из текущей вершины
-    IntVector currentVertex;
-    currentVertex << vertex;
-
-    // Ищем низлежащие пути
-    for (int i = vertex + 1; i < m_stackCoordinates.count(); i++)
-    {
-        if (m_adjacencyMatrix[vertex][i] >= 0)
-        {
-            IntVectorList flowingSubpaths = pathsFrom(i);
-            foreach (const IntVector &flowingSubpath, flowingSubpaths)
-            {
-                IntVector path;
-                path << currentVertex;
-                path << flowingSubpath;
-                result << path;
-            }
-        }
-    }
-
-    if (result.isEmpty())
-    {
-        // Низлежащих путей нет
-        result << currentVertex;
-    }
-    return result;
+    buildVertexes();
+    buildGraph();
 }
 
 int GridCoordinateGenerator::pathLength(const IntVector &path) const
@@ -361,7 +573,7 @@ int GridCoordinateGenerator::pathLength(const IntVector &path) const
     {
         int vertex1 = path[i];
         int vertex2 = path[i+1];
-        int w = m_adjacencyMatrix[vertex1][vertex2];
+        int w = m_graph.weight(vertex1, vertex2);
         if (w < 0)
         {
             // Некорректный путь
@@ -375,26 +587,43 @@ int GridCoordinateGenerator::pathLength(const IntVector &path) const
     return sum;
 }
 
-void GridCoordinateGenerator::computePaths()
-{
-    m_paths.clear();
-    if (m_stackCoordinates.count() >= 2)
-    {
-        m_paths = pathsFrom(0);
-    }
-}
-
 void GridCoordinateGenerator::computeLongestPath()
 {
     m_longestPath = IntVector();
     m_maxPathLength = 0;
-    foreach (const IntVector &path, m_paths)
+
+    int count = m_stackCoordinates.count();
+    if (count < 2)
     {
-        int length = pathLength(path);
-        if (m_maxPathLength < length)
+        return;
+    }
+
+    // Вершины упорядочены по stack-координате, и рёбра ведут только от меньшего номера к большему,
+    // поэтому нумерация вершин уже является топологическим порядком. Наибольшие длины путей до последней
+    // вершины вычисляются одним обратным проходом. При равенстве длин запоминается следующая вершина
+    // с меньшим номером: так выбирается первый из наибольших путей в лексикографическом порядке.
+    IntVector lengths(count, 0);
+    IntVector successors(count, -1);
+    for (int vertex = count-2; vertex >= 0; vertex--)
+    {
+        for (int edge = m_graph.firstEdge(vertex); edge < m_graph.lastEdge(vertex); edge++)
         {
-            m_maxPathLength = length;
-            m_longestPath = path;
+            int i = m_graph.edgeTarget(edge);
+            int length = m_graph.edgeWeight(edge) + lengths[i];
+            if ((successors[vertex] < 0) || (lengths[vertex] < length))
+            {
+                lengths[vertex] = length;
+                successors[vertex] = i;
+            }
+        }
+    }
+
+    if (lengths[0] > 0)
+    {
+        m_maxPathLength = lengths[0];
+        for (int vertex = 0; vertex >= 0; vertex = successors[vertex])
+        {
+            m_longestPath << vertex;
         }
     }
 }
@@ -434,7 +663,7 @@ IntVector GridCoordinateGenerator::gridCoordinatesForPath(const GridSegment &gri
         int edgeLength = 0;
         int vertex1 = path[i-1];
         int vertex2 = path[i];
-        if (m_adjacencyMatrix[vertex1][vertex2] >= 1)
+        if (m_graph.weight(vertex1, vertex2) >= 1)
         {
             edgeLength = m_minimalSegmentGridLength;
         }
@@ -457,7 +686,7 @@ IntVector GridCoordinateGenerator::gridCoordinatesForPath(const GridSegment &gri
             int vertex1 = path[i-1];
             int vertex2 = path[i];
             double edgeRemainStackLength = m_stackCoordinates[vertex2] - m_stackCoordinates[vertex1];
-            if (m_adjacencyMatrix[vertex1][vertex2] >= 1)
+            if (m_graph.weight(vertex1, vertex2) >= 1)
             {
                 edgeRemainStackLength -= segmentMinStackLength;
             }
@@ -489,70 +718,343 @@ void GridCoordinateGenerator::setGridCoordinatesForPath(const GridSegment &gridS
     }
 }
 
-IntVector GridCoordinateGenerator::findBearingPath1(int vertex, const IntVector &path) const
+IntVector GridCoordinateGenerator::findBearingPath1(int vertex, int &spanMin, int &spanMax) const
 {
+    // Опорный путь - участок пути графа, проходящего через vertex, между ближайшими к vertex вершинами
+    // с уже вычисленными grid-координатами. Среди всех путей выбирается наибольший по длине участок,
+    // а при равенстве длин - участок первого пути в лексикографическом порядке.
+    // Результат зависит только от рёбер и grid-координат вершин из диапазона [spanMin, spanMax].
     IntVector result;
-    int vertexIndex = path.indexOf(vertex);
-    if (vertexIndex >= 0)
+    int count = m_stackCoordinates.count();
+    spanMin = vertex;
+    spanMax = vertex;
+    if ((vertex <= 0) || (vertex >= count-1))
+    {
+        return result;
+    }
+
+    // Вершины, достижимые из vertex через вершины без grid-координат, и концы их рёбер лежат не правее spanMax
+    for (int i = vertex; i <= spanMax; i++)
+    {
+        if ((i == vertex) || (m_gridCoordinates[i] < 0))
+        {
+            spanMax = qMax(spanMax, m_graph.edgeTarget(m_graph.lastEdge(i) - 1));
+        }
+    }
+
+    // Наибольшая длина участка от вершины (vertex или следующей за ней) до первой вершины с grid-координатой;
+    // элементы массивов соответствуют вершинам vertex..spanMax
+    IntVector forwardLengths(spanMax - vertex + 1, -1);
+    IntVector forwardSuccessors(spanMax - vertex + 1, -1);
+    for (int i = spanMax-1; i >= vertex; i--)
     {
-        int startFrom = vertexIndex;
-        for (int i = vertexIndex-1; i >= 0; i--)
+        if ((i != vertex) && (m_gridCoordinates[i] >= 0))
         {
-            startFrom = i;
-            if (m_gridCoordinates[path[i]] >= 0)
+            continue;
+        }
+        for (int edge = m_graph.firstEdge(i); edge < m_graph.lastEdge(i); edge++)
+        {
+            int j = m_graph.edgeTarget(edge);
+            int w = m_graph.edgeWeight(edge);
+            int length = (m_gridCoordinates[j] >= 0) ? w : w + forwardLengths[j - vertex];
+            if (forwardLengths[i - vertex] < length)
             {
-                break;
+                forwardLengths[i - vertex] = length;
+                forwardSuccessors[i - vertex] = j;
+            }
+        }
+    }
+
+    // Наибольшая длина пути от вершины до vertex через вершины без grid-координат (-1, если такого пути нет);
+    // элементы массива соответствуют вершинам vertex, vertex-1, ..., spanMin. Начала таких путей лежат
+    // не левее вершин, из которых есть рёбра в vertex и в промежуточные вершины путей.
+    IntVector backwardLengths;
+    backwardLengths << 0;
+    spanMin = m_graph.firstSource(vertex);
+    for (int i = vertex-1; i >= spanMin; i--)
+    {
+        int length = -1;
+        for (int edge = m_graph.firstEdge(i); (edge < m_graph.lastEdge(i)) && (m_graph.edgeTarget(edge) <= vertex); edge++)
+        {
+            int j = m_graph.edgeTarget(edge);
+            if ((backwardLengths[vertex - j] >= 0) && ((j == vertex) || (m_gridCoordinates[j] < 0)))
+            {
+                length = qMax(length, m_graph.edgeWeight(edge) + backwardLengths[vertex - j]);
             }
         }
-        int endTo = vertexIndex;
-        for (int i = vertexIndex+1; i < path.count(); i++)
+        backwardLengths << length;
+        if ((length >= 0) && (m_gridCoordinates[i] < 0) && (m_graph.firstSource(i) >= 0))
+        {
+            spanMin = qMin(spanMin, m_graph.firstSource(i));
+        }
+    }
+
+    // Наибольшая длина участка до vertex, начинающегося в вершине с grid-координатой. Проход от начала графа,
+    // выбирающий каждый раз следующую вершину с наименьшим номером, после которой ещё достижима эта длина,
+    // проходит все вершины подряд до самой правой из таких начал участка.
+    int targetBackwardLength = -1;
+    int bearingVertex = -1;
+    for (int i = vertex-1; i >= spanMin; i--)
+    {
+        if ((m_gridCoordinates[i] >= 0) && (targetBackwardLength < backwardLengths[vertex - i]))
+        {
+            targetBackwardLength = backwardLengths[vertex - i];
+            bearingVertex = i;
+        }
+    }
+    if ((targetBackwardLength < 0) || (targetBackwardLength + forwardLengths[0] <= 0))
+    {
+        return result;
+    }
+
+    // Продолжаем проход от этого начала до vertex по вершинам без grid-координат
+    result << bearingVertex;
+    int accumulatedLength = 0;
+    for (int i = bearingVertex; i != vertex;)
+    {
+        int next = -1;
+        int nextAccumulatedLength = 0;
+        for (int edge = m_graph.firstEdge(i); (edge < m_graph.lastEdge(i)) && (next < 0); edge++)
         {
-            endTo = i;
-            if (m_gridCoordinates[path[i]] >= 0)
+            int j = m_graph.edgeTarget(edge);
+            int currentAccumulatedLength = accumulatedLength + m_graph.edgeWeight(edge);
+            if (j > vertex)
             {
                 break;
             }
+            if (j == vertex)
+            {
+                if (currentAccumulatedLength == targetBackwardLength)
+                {
+                    next = j;
+                    nextAccumulatedLength = currentAccumulatedLength;
+                }
+            }
+            else if ((m_gridCoordinates[j] < 0) && (backwardLengths[vertex - j] >= 0) &&
+                     (currentAccumulatedLength + backwardLengths[vertex - j] == targetBackwardLength))
+            {
+                next = j;
+                nextAccumulatedLength = currentAccumulatedLength;
+            }
         }
-        result = path.mid(startFrom, endTo - startFrom + 1);
+        if (next < 0)
+        {
+            return IntVector();
+        }
+        result << next;
+        accumulatedLength = nextAccumulatedLength;
+        i = next;
     }
-    return result;
-}
 
-IntVector GridCoordinateGenerator::findBearingPath1(int vertex) const
-{
-    IntVector result;
-    int resultLength = 0;
-    foreach (const IntVector &path, m_paths)
+    // Продолжаем от vertex до первой вершины с grid-координатой
+    for (int i = forwardSuccessors[0]; i >= 0; i = forwardSuccessors[i - vertex])
     {
-        IntVector currentPath = findBearingPath1(vertex, path);
-        int currentLength = pathLength(currentPath);
-        if (resultLength < currentLength)
+        result << i;
+        if (m_gridCoordinates[i] >= 0)
         {
-            resultLength = currentLength;
-            result = currentPath;
+            break;
         }
     }
     return result;
 }
 
-void GridCoordinateGenerator::computeGridCoordinates()
+void GridCoordinateGenerator::computeGridCoordinates(const GridCoordinateGenerator &previous)
 {
-    m_gridCoordinates.fill(-1, m_stackCoordinates.count());
-    if ((!m_paths.isEmpty()) && (m_longestPath.count() >= 2))
+    // Результат предыдущего вычисления (previous) используется повторно везде, где изменение его не затронуло.
+    // Вершины сопоставляются по stack-координате. changedStructures отмечает вершины, у которых могли
+    // измениться рёбра или момент получения grid-координаты, changedValues - вершины, у которых могла
+    // измениться сама grid-координата. Опорный путь вершины ищется заново, только если в диапазоне вершин,
+    // от которых он зависел, есть изменения структуры, а его grid-координаты пересчитываются, только если
+    // могли измениться координаты вершин пути.
+    int count = m_stackCoordinates.count();
+    m_gridCoordinates.fill(-1, count);
+    m_bearingPaths.clear();
+    if (m_longestPath.count() < 2)
+    {
+        return;
+    }
+
+    // Соответствие вершин: previousVertexes - номер прежней вершины для текущей, currentVertexes - наоборот
+    int previousCount = previous.m_stackCoordinates.count();
+    IntVector previousVertexes(count, -1);
+    IntVector currentVertexes(previousCount, -1);
+    for (int vertex = 0, previousVertex = 0; (vertex < count) && (previousVertex < previousCount);)
+    {
+        if (m_stackCoordinates[vertex] < previous.m_stackCoordinates[previousVertex])
+        {
+            vertex++;
+        }
+        else if (previous.m_stackCoordinates[previousVertex] < m_stackCoordinates[vertex])
+        {
+            previousVertex++;
+        }
+        else
+        {
+            previousVertexes[vertex] = previousVertex;
+            currentVertexes[previousVertex] = vertex;
+            vertex++;
+            previousVertex++;
+        }
+    }
+    QVector<bool> changedStructures(count, false);
+    QVector<bool> changedValues(count, m_minimalSegmentGridLength != previous.m_minimalSegmentGridLength);
+
+    // Вершины, у которых изменился набор исходящих рёбер; изменение ребра затрагивает обе его вершины
+    QVector<bool> changedEdges(count, false);
+    for (int vertex = 0; vertex < count; vertex++)
+    {
+        int previousVertex = previousVertexes[vertex];
+        bool isChanged = (previousVertex < 0) ||
+                (m_graph.lastEdge(vertex) - m_graph.firstEdge(vertex) != previous.m_graph.lastEdge(previousVertex) - previous.m_graph.firstEdge(previousVertex));
+        for (int edge = m_graph.firstEdge(vertex), previousEdge = (previousVertex >= 0) ? previous.m_graph.firstEdge(previousVertex) : 0;
+             (!isChanged) && (edge < m_graph.lastEdge(vertex)); edge++, previousEdge++)
+        {
+            isChanged = (m_graph.edgeTarget(edge) != currentVertexes[previous.m_graph.edgeTarget(previousEdge)]) ||
+                    (m_graph.edgeWeight(edge) != previous.m_graph.edgeWeight(previousEdge));
+        }
+        changedEdges[vertex] = isChanged;
+    }
+    for (int vertex = 0; vertex < count; vertex++)
+    {
+        if (changedEdges[vertex])
+        {
+            changedStructures[vertex] = true;
+            for (int edge = m_graph.firstEdge(vertex); edge < m_graph.lastEdge(vertex); edge++)
+            {
+                changedStructures[m_graph.edgeTarget(edge)] = true;
+            }
+        }
+    }
+    for (int previousVertex = 0; previousVertex < previousCount; previousVertex++)
+    {
+        if ((currentVertexes[previousVertex] >= 0) && (!changedEdges[currentVertexes[previousVertex]]))
+        {
+            continue;
+        }
+        for (int edge = previous.m_graph.firstEdge(previousVertex); edge < previous.m_graph.lastEdge(previousVertex); edge++)
+        {
+            int vertex = currentVertexes[previous.m_graph.edgeTarget(edge)];
+            if (vertex >= 0)
+            {
+                changedStructures[vertex] = true;
+            }
+        }
+    }
+
+    // Наибольший путь
+    QVector<bool> pathMarks(count, false);
+    markVertexes(m_longestPath, pathMarks);
+    QVector<bool> previousPathMarks(count, false);
+    markVertexes(mapVertexes(previous.m_longestPath, currentVertexes), previousPathMarks);
+    setGridCoordinatesForPath(m_gridSpace, m_longestPath);
+    for (int vertex = 0; vertex < count; vertex++)
+    {
+        if (pathMarks[vertex] != previousPathMarks[vertex])
+        {
+            changedStructures[vertex] = true;
+        }
+        if ((pathMarks[vertex]) && ((previousVertexes[vertex] < 0) || (m_gridCoordinates[vertex] != previous.m_gridCoordinates[previousVertexes[vertex]])))
+        {
+            changedValues[vertex] = true;
+        }
+    }
+
+    // Прежние опорные пути по прежним вершинам; пути исчезнувших вершин получат другие вершины
+    IntVector previousBearingPathIndexes(previousCount, -1);
+    for (int i = 0; i < previous.m_bearingPaths.count(); i++)
+    {
+        const GridBearingPath &previousBearingPath = previous.m_bearingPaths[i];
+        if (currentVertexes[previousBearingPath.vertex] >= 0)
+        {
+            previousBearingPathIndexes[previousBearingPath.vertex] = i;
+        }
+        else
+        {
+            markVertexes(mapVertexes(previousBearingPath.path, currentVertexes), changedStructures);
+        }
+    }
+
+    // Ближайшие сохранившиеся вершины слева и справа от прежней вершины (для переноса диапазонов)
+    IntVector lowerVertexes(previousCount, 0);
+    IntVector upperVertexes(previousCount, count-1);
+    for (int previousVertex = 0, vertex = 0; previousVertex < previousCount; previousVertex++)
+    {
+        vertex = (currentVertexes[previousVertex] >= 0) ? currentVertexes[previousVertex] : vertex;
+        lowerVertexes[previousVertex] = vertex;
+    }
+    for (int previousVertex = previousCount-1, vertex = count-1; previousVertex >= 0; previousVertex--)
     {
-        setGridCoordinatesForPath(m_gridSpace, m_longestPath);
-        for (int vertex = 0; vertex < m_gridCoordinates.count(); vertex++)
+        vertex = (currentVertexes[previousVertex] >= 0) ? currentVertexes[previousVertex] : vertex;
+        upperVertexes[previousVertex] = vertex;
+    }
+
+    for (int vertex = 0; vertex < count; vertex++)
+    {
+        int previousVertex = previousVertexes[vertex];
+        int previousIndex = (previousVertex >= 0) ? previousBearingPathIndexes[previousVertex] : -1;
+        IntVector previousPath;
+        if (previousIndex >= 0)
+        {
+            previousPath = mapVertexes(previous.m_bearingPaths[previousIndex].path, currentVertexes);
+        }
+        if (m_gridCoordinates[vertex] >= 0)
+        {
+            // Вершина уже получила grid-координату, а прежде для неё искался опорный путь
+            markVertexes(previousPath, changedStructures);
+            markVertexes(previousPath, changedValues);
+            continue;
+        }
+
+        GridBearingPath bearingPath;
+        bearingPath.vertex = vertex;
+        bool isReused = false;
+        if (previousIndex >= 0)
+        {
+            bearingPath.spanMin = lowerVertexes[previous.m_bearingPaths[previousIndex].spanMin];
+            bearingPath.spanMax = upperVertexes[previous.m_bearingPaths[previousIndex].spanMax];
+            isReused = (!previousPath.contains(-1)) && (!hasMarkedVertex(changedStructures, bearingPath.spanMin, bearingPath.spanMax));
+        }
+        if (isReused)
+        {
+            bearingPath.path = previousPath;
+        }
+        else
+        {
+            bearingPath.path = findBearingPath1(vertex, bearingPath.spanMin, bearingPath.spanMax);
+            if (bearingPath.path != previousPath)
+            {
+                markVertexes(previousPath, changedStructures);
+                markVertexes(previousPath, changedValues);
+                markVertexes(bearingPath.path, changedStructures);
+                markVertexes(bearingPath.path, changedValues);
+            }
+        }
+
+        const IntVector &path = bearingPath.path;
+        if (path.count() >= 3)
         {
-            if (m_gridCoordinates[vertex] == -1)
+            if ((isReused) && (!hasMarkedVertex(changedValues, path)))
             {
-                IntVector bearingPath = findBearingPath1(vertex);
-                if (bearingPath.count() >= 3)
+                foreach (int pathVertex, path)
                 {
-                    GridSegment subGridSpace(m_gridCoordinates[bearingPath.first()], m_gridCoordinates[bearingPath.last()]);
-                    setGridCoordinatesForPath(subGridSpace, bearingPath);
+                    m_gridCoordinates[pathVertex] = previous.m_gridCoordinates[previousVertexes[pathVertex]];
+                }
+            }
+            else
+            {
+                GridSegment subGridSpace(m_gridCoordinates[path.first()], m_gridCoordinates[path.last()]);
+                setGridCoordinatesForPath(subGridSpace, path);
+                for (int i = 1; i < path.count()-1; i++)
+                {
+                    int pathVertex = path[i];
+                    if ((previousVertexes[pathVertex] < 0) || (m_gridCoordinates[pathVertex] != previous.m_gridCoordinates[previousVertexes[pathVertex]]))
+                    {
+                        changedValues[pathVertex] = true;
+                    }
                 }
             }
         }
+        m_bearingPaths << bearingPath;
     }
 }
 
@@ -571,14 +1073,59 @@ void GridCoordinateGenerator::computeGridSegmentList()
 
 void GridCoordinateGenerator::computeAll()
 {
+    GridCoordinateGenerator previous(*this);
     computeGraph();
-    computePaths();
     computeLongestPath();
     computeGridSpace();
-    computeGridCoordinates();
+    computeGridCoordinates(previous);
     computeGridSegmentList();
 }
 
+IntVector GridCoordinateGenerator::mapVertexes(const IntVector &vertexes, const IntVector &vertexMap)
+{
+    IntVector result(vertexes.count(), -1);
+    for (int i = 0; i < vertexes.count(); i++)
+    {
+        result[i] = vertexMap[vertexes[i]];
+    }
+    return result;
+}
+
+void GridCoordinateGenerator::markVertexes(const IntVector &vertexes, QVector<bool> &marks)
+{
+    foreach (int vertex, vertexes)
+    {
+        if (vertex >= 0)
+        {
+            marks[vertex] = true;
+        }
+    }
+}
+
+bool GridCoordinateGenerator::hasMarkedVertex(const QVector<bool> &marks, const IntVector &vertexes)
+{
+    foreach (int vertex, vertexes)
+    {
+        if (marks[vertex])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GridCoordinateGenerator::hasMarkedVertex(const QVector<bool> &marks, int fromVertex, int toVertex)
+{
+    for (int vertex = fromVertex; vertex <= toVertex; vertex++)
+    {
+        if (marks[vertex])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 void GridCoordinateGenerator::reduceStackCoordinates(const DoubleVector &rawSortedStackCoordinates, const IntVector &rawSortedIndexes, DoubleVector &reducedStackCoordinates, IntVector &reducedIndexes)
 {
     static const double samplingCoef = 10000;
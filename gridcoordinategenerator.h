@@ -35,6 +35,39 @@ struct GridSegment
 };
 typedef QList<GridSegment> GridSegmentList;
 
+class GridGraph
+{
+public:
+    GridGraph();
+    void clear();
+    void build(int vertexCount, const IntVector &segmentVertexes);
+    int vertexCount() const;
+    int edgeCount() const;
+    int firstEdge(int vertex) const;
+    int lastEdge(int vertex) const;
+    int edgeTarget(int edge) const;
+    int edgeWeight(int edge) const;
+    int weight(int vertex1, int vertex2) const;
+    int firstSource(int vertex) const;
+
+private:
+    IntVector m_offsets;
+    IntVector m_targets;
+    IntVector m_constraintCounts;
+    IntVector m_firstSources;
+    int findEdge(int vertex1, int vertex2) const;
+};
+
+struct GridBearingPath
+{
+    int vertex;
+    int spanMin;
+    int spanMax;
+    IntVector path;
+    GridBearingPath();
+};
+typedef QList<GridBearingPath> GridBearingPathList;
+
 class GridCoordinateGenerator
 {
 public:
@@ -42,6 +75,7 @@ public:
     void setMinimalSegmentGridLength(int value);
     int minimalSegmentGridLength() const;
     void setStackSegmentList(const StackSegmentList &value);
+    void setStackSegment(int index, const StackSegment &value);
     StackSegmentList stackSegmentList() const;
     int minimalGridSpaceLength() const;
     void setSupposedGridSpace(const GridSegment &value);
@@ -60,29 +94,33 @@ private:
     GridSegmentList m_gridSegmentList;
     IntVector m_vertexIndexes;
     DoubleVector m_stackCoordinates;
-    IntVectorList m_adjacencyMatrix;
-    IntVectorList m_paths;
+    IntVector m_sortedStackIndexes;
+    GridGraph m_graph;
     int m_maxPathLength;
     IntVector m_longestPath;
     IntVector m_gridCoordinates;
+    GridBearingPathList m_bearingPaths;
 
+    DoubleVector rawStackCoordinates() const;
     void buildVertexes();
-    void buildAdjacencyMatrix();
+    void updateVertexes(int index);
+    void buildGraph();
     void computeGraph();
-    IntVectorList pathsFrom(int vertex) const;
     int pathLength(const IntVector &path) const;
-    void computePaths();
     void computeLongestPath();
     void computeGridSpace();
     IntVector gridCoordinatesForPath(const GridSegment &gridSpace, const IntVector &path) const;
     void setGridCoordinatesForPath(const GridSegment &gridSpace, const IntVector &path);
-    IntVector findBearingPath1(int vertex, const IntVector &path) const;
-    IntVector findBearingPath1(int vertex) const;
+    IntVector findBearingPath1(int vertex, int &spanMin, int &spanMax) const;
 
-    void computeGridCoordinates();
+    void computeGridCoordinates(const GridCoordinateGenerator &previous);
     void computeGridSegmentList();
     void computeAll();
 
+    static IntVector mapVertexes(const IntVector &vertexes, const IntVector &vertexMap);
+    static void markVertexes(const IntVector &vertexes, QVector<bool> &marks);
+    static bool hasMarkedVertex(const QVector<bool> &marks, const IntVector &vertexes);
+    static bool hasMarkedVertex(const QVector<bool> &marks, int fromVertex, int toVertex);
     static void reduceStackCoordinates(const DoubleVector &rawSortedStackCoordinates, const IntVector &rawSortedIndexes, DoubleVector &reducedStackCoordinates, IntVector &reducedIndexes);
 };
 
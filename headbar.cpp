@@ -135,7 +135,7 @@ void TabSwitcherObject::paint(QPainter *painter)
     paintEmbryo(painter);
 }
 
-void TabSwitcherObject::handleEvent(UserEvent event)
+bool TabSwitcherObject::handleEvent(UserEvent event)
 {
     if ((event.type == UserEvent::MouseDown) && (event.button == Qt::LeftButton))
     {
@@ -150,7 +150,7 @@ void TabSwitcherObject::handleEvent(UserEvent event)
             if (index >= 0)
             {
                 emit tabController()->tabToBeRemoved(index);
-                return;
+                return true;
             }
 
             QPointF offset;
@@ -165,7 +165,7 @@ void TabSwitcherObject::handleEvent(UserEvent event)
                 m_clickOffset = offset;
                 m_clickTabUid = data().items[index].uid;
                 m_isDragging = false;
-                return;
+                return true;
             }
         }
     }
@@ -193,6 +193,8 @@ void TabSwitcherObject::handleEvent(UserEvent event)
         m_clickTabUid = QUuid();
         m_isDragging = false;
     }
+    // Колесо вкладки не переключают
+    return (event.type != UserEvent::MouseWheel);
 }
 
 QSizeF TabSwitcherObject::sizeConstraint(const QSizeF &) const
@@ -41,7 +41,7 @@ public:
     void ceaseMoving() override;
     TabController* tabController() const;
     void paint(QPainter *painter) override;
-    void handleEvent(UserEvent event) override;
+    bool handleEvent(UserEvent event) override;
     QSizeF sizeConstraint(const QSizeF &supposedSize) const override;
 
 private:
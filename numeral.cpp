@@ -1,6 +1,7 @@
 #include "numeral.h"
 #include <float.h>
 #include <math.h>
+#include <string.h>
 
 #include <QDebug>
 
@@ -39,7 +40,7 @@ NumeralFormat::NumeralFormat(bool sign, bool thousandSeparate, int precision, bo
     setPercent(percent);
 }
 
-bool NumeralFormat::operator == (const NumeralFormat &another)
+bool NumeralFormat::operator == (const NumeralFormat &another) const
 {
     return
             (m_sign == another.m_sign) &&
@@ -49,7 +50,7 @@ bool NumeralFormat::operator == (const NumeralFormat &another)
             (m_percent == another.m_percent);
 }
 
-bool NumeralFormat::operator != (const NumeralFormat &another)
+bool NumeralFormat::operator != (const NumeralFormat &another) const
 {
     return !(operator ==(another));
 }
@@ -217,18 +218,54 @@ void NumeralFormat::parseFractionalPart(const QStringRef &st)
 }
 
 
+//******************************************************************************************************
+/*!
+ *\struct NumeralSymbols
+ *\brief Символы локали, нужные для записи числа; достаются из QLocale один раз.
+*/
+//******************************************************************************************************
+
+NumeralSymbols::NumeralSymbols()
+    : zeroDigit('0')
+    , decimalPoint('.')
+    , groupSeparator(',')
+    , negativeSign('-')
+    , positiveSign('+')
+    , percent('%')
+{
+
+}
+
+NumeralSymbols::NumeralSymbols(const QLocale &locale)
+    : zeroDigit(locale.zeroDigit())
+    , decimalPoint(locale.decimalPoint())
+    , groupSeparator(locale.groupSeparator())
+    , negativeSign(locale.negativeSign())
+    , positiveSign(locale.positiveSign())
+    , percent(locale.percent())
+{
+
+}
+
+
 //******************************************************************************************************
 /*!
  *\class Numeral
+ *
+ * Обычно число записывается быстрым путём (formatFast) сразу в буфер символов, без промежуточных
+ * строк. Редкие случаи - NaN, очень большие числа, значения на самой границе округления,
+ * локали с нелатинскими цифрами - записываются прежним путём через QLocale::toString().
 */
 //******************************************************************************************************
 
 QLocale *Numeral::m_defaultLocale = NULL;
+NumeralSymbols *Numeral::m_defaultSymbols = NULL;
 QString *Numeral::m_defaultNanStub = NULL;
 
 Numeral::Numeral()
     : m_numberFormat()
     , m_locale(defaultLocale())
+    , m_symbols(*m_defaultSymbols)
     , m_nanStub(defaultNanStub())
 {
     m_locale.setNumberOptions(QLocale::OmitGroupSeparator);
@@ -237,6 +274,7 @@ Numeral::Numeral()
 Numeral::Numeral(const NumeralFormat &format)
     : m_numberFormat(format)
     , m_locale(defaultLocale())
+    , m_symbols(*m_defaultSymbols)
     , m_nanStub(defaultNanStub())
 {
     m_locale.setNumberOptions(QLocale::OmitGroupSeparator);
@@ -245,6 +283,7 @@ Numeral::Numeral(const NumeralFormat &format)
 Numeral::Numeral(const NumeralFormat &format, const QLocale &locale)
     : m_numberFormat(format)
     , m_locale(locale)
+    , m_symbols(locale)
     , m_nanStub(defaultNanStub())
 {
     m_locale.setNumberOptions(QLocale::OmitGroupSeparator);
@@ -264,6 +303,7 @@ void Numeral::setlocale(const QLocale &value)
 {
     m_locale = value;
     m_locale.setNumberOptions(QLocale::OmitGroupSeparator);
+    m_symbols = NumeralSymbols(value);
 }
 
 QLocale Numeral::locale() const
@@ -285,6 +325,7 @@ void Numeral::setDefaultLocale(const QLocale &value)
 {
     createDefaultLocaleIfNeeded();
     *m_defaultLocale = value;
+    *m_defaultSymbols = NumeralSymbols(value);
 }
 
 QLocale Numeral::defaultLocale()
@@ -306,6 +347,44 @@ QString Numeral::defaultNanStub()
 }
 
 QString Numeral::toString(double number) const
+{
+    QChar buffer[BufferSize];
+    int length = formatFast(number, m_numberFormat, m_symbols, buffer, BufferSize);
+    return (length >= 0) ? QString(buffer, length) : toStringSlow(number);
+}
+
+int Numeral::toChars(double number, QChar *buffer, int size) const
+{
+    int length = formatFast(number, m_numberFormat, m_symbols, buffer, size);
+    return (length >= 0) ? length : copyToChars(toStringSlow(number), buffer, size);
+}
+
+QString Numeral::format(double number, const NumeralFormat &numberFormat)
+{
+    createDefaultLocaleIfNeeded();
+    QChar buffer[BufferSize];
+    int length = formatFast(number, numberFormat, *m_defaultSymbols, buffer, BufferSize);
+    if (length >= 0)
+    {
+        return QString(buffer, length);
+    }
+    Numeral n(numberFormat);
+    return n.toStringSlow(number);
+}
+
+int Numeral::format(double number, const NumeralFormat &numberFormat, QChar *buffer, int size)
+{
+    createDefaultLocaleIfNeeded();
+    int length = formatFast(number, numberFormat, *m_defaultSymbols, buffer, size);
+    if (length >= 0)
+    {
+        return length;
+    }
+    Numeral n(numberFormat);
+    return copyToChars(n.toStringSlow(number), buffer, size);
+}
+
+QString Numeral::toStringSlow(double number) const
 {
     if (isNan(number))
     {
@@ -326,12 +405,6 @@ QString Numeral::toString(double number) const
     }
 }
 
-QString Numeral::format(double number, const NumeralFormat &numberFormat)
-{
-    Numeral n(numberFormat);
-    return n.toString(number);
-}
-
 QString Numeral::decorateSign(const QString &formattedNumber, double number) const
 {
     QString sign;
@@ -418,6 +491,7 @@ void Numeral::createDefaultLocaleIfNeeded()
     if (m_defaultLocale == NULL)
     {
         m_defaultLocale = new QLocale;
+        m_defaultSymbols = new NumeralSymbols(*m_defaultLocale);
     }
 }
 
@@ -428,3 +502,117 @@ void Numeral::createDefaultNanStubIfNeeded()
         m_defaultNanStub = new QString;
     }
 }
+
+int Numeral::copyToChars(const QString &text, QChar *buffer, int size)
+{
+    if (text.length() > size)
+    {
+        return -1;
+    }
+    memcpy(buffer, text.constData(), text.length() * sizeof(QChar));
+    return text.length();
+}
+
+int Numeral::formatFast(double number, const NumeralFormat &numberFormat, const NumeralSymbols &symbols, QChar *buffer, int size)
+{
+    // Число с фиксированной точностью получается округлением number * 10^precision до целого.
+    // Пока произведение меньше 2^43, его погрешность меньше 2^-11, и округление совпадает
+    // с точным (как в QLocale::toString), если дробная часть не ближе 2^-8 к половине.
+    // В остальных случаях возвращается -1 - число записывается прежним путём.
+    static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    static const double maximalScaled = 8796093022208.0; // 2^43
+    static const double roundingMargin = 1.0 / 256;
+    if ((isNan(number)) || (symbols.zeroDigit != QLatin1Char('0')))
+    {
+        return -1;
+    }
+    double cnumber = (numberFormat.percent())? number*100.0 : number;
+    int precision = (numberFormat.extraPrecision())? 6 : qMax(numberFormat.precision(), 0);
+    if (precision > 15)
+    {
+        return -1;
+    }
+    double scaled = (fabs(cnumber) + DBL_EPSILON) * powersOfTen[precision];
+    if (!(scaled < maximalScaled))
+    {
+        return -1;
+    }
+    double integral = floor(scaled);
+    double fraction = scaled - integral;
+    if (fabs(fraction - 0.5) < roundingMargin)
+    {
+        return -1;
+    }
+    quint64 digits = quint64(integral) + ((fraction > 0.5)? 1 : 0);
+
+    // Дробная часть; при extraPrecision лишние нули в конце отбрасываются
+    char fractionDigits[16];
+    for (int i = precision-1; i >= 0; i--)
+    {
+        fractionDigits[i] = '0' + char(digits % 10);
+        digits /= 10;
+    }
+    int fractionLength = precision;
+    if (numberFormat.extraPrecision())
+    {
+        int minimalLength = qBound(0, numberFormat.precision(), precision);
+        while ((fractionLength > minimalLength) && (fractionDigits[fractionLength-1] == '0'))
+        {
+            fractionLength--;
+        }
+    }
+
+    // Целая часть - в обратном порядке
+    char integerDigits[16];
+    int integerLength = 0;
+    do
+    {
+        integerDigits[integerLength++] = '0' + char(digits % 10);
+        digits /= 10;
+    }
+    while (digits > 0);
+
+    bool negative = (cnumber < -DBL_EPSILON);
+    bool positive = (cnumber > +DBL_EPSILON) && (numberFormat.sign());
+    int groupCount = (numberFormat.thousandSeparate())? ((integerLength-1) / 3) : 0;
+    int length =
+            (((negative) || (positive))? 1 : 0) +
+            integerLength + groupCount +
+            ((fractionLength > 0)? (fractionLength + 1) : 0) +
+            ((numberFormat.percent())? 1 : 0);
+    if (length > size)
+    {
+        return -1;
+    }
+
+    QChar *out = buffer;
+    if (negative)
+    {
+        *out++ = symbols.negativeSign;
+    }
+    else if (positive)
+    {
+        *out++ = symbols.positiveSign;
+    }
+    for (int i = integerLength-1; i >= 0; i--)
+    {
+        *out++ = QLatin1Char(integerDigits[i]);
+        if ((groupCount > 0) && (i > 0) && (i % 3 == 0))
+        {
+            *out++ = symbols.groupSeparator;
+        }
+    }
+    if (fractionLength > 0)
+    {
+        *out++ = symbols.decimalPoint;
+        for (int i = 0; i < fractionLength; i++)
+        {
+            *out++ = QLatin1Char(fractionDigits[i]);
+        }
+    }
+    if (numberFormat.percent())
+    {
+        *out++ = symbols.percent;
+    }
+    return out - buffer;
+}
@@ -10,8 +10,8 @@ public:
     NumeralFormat();
     NumeralFormat(const QString &st);
     NumeralFormat(bool sign, bool thousandSeparate, int precision, bool extraPrecision, bool percent);
-    bool operator == (const NumeralFormat &another);
-    bool operator != (const NumeralFormat &another);
+    bool operator == (const NumeralFormat &another) const;
+    bool operator != (const NumeralFormat &another) const;
     void clear();
     void setFormatString(const QString &st);
     QString formatString() const;
@@ -37,9 +37,22 @@ private:
     void parseFractionalPart(const QStringRef &st);
 };
 
+struct NumeralSymbols
+{
+    QChar zeroDigit;
+    QChar decimalPoint;
+    QChar groupSeparator;
+    QChar negativeSign;
+    QChar positiveSign;
+    QChar percent;
+    NumeralSymbols();
+    NumeralSymbols(const QLocale &locale);
+};
+
 class Numeral
 {
 public:
+    enum {BufferSize = 64};
     Numeral();
     Numeral(const NumeralFormat &numberFormat);
     Numeral(const NumeralFormat &numberFormat, const QLocale &locale);
@@ -54,14 +67,21 @@ public:
     static void setDefaultNanStub(const QString &value);
     static QString defaultNanStub();
     QString toString(double number) const;
+    int toChars(double number, QChar *buffer, int size) const;
     static QString format(double number, const NumeralFormat &numberFormat = NumeralFormat());
+    static int format(double number, const NumeralFormat &numberFormat, QChar *buffer, int size);
 
 private:
     NumeralFormat m_numberFormat;
     QLocale m_locale;
+    NumeralSymbols m_symbols;
     QString m_nanStub;
     static QLocale *m_defaultLocale;
+    static NumeralSymbols *m_defaultSymbols;
     static QString *m_defaultNanStub;
+    QString toStringSlow(double number) const;
+    static int copyToChars(const QString &text, QChar *buffer, int size);
+    static int formatFast(double number, const NumeralFormat &numberFormat, const NumeralSymbols &symbols, QChar *buffer, int size);
 
 public:
     QString decorateSign(const QString &formattedNumber, double number) const;
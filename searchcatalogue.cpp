@@ -0,0 +1,102 @@
+#include "searchcatalogue.h"
+#include <QStringList>
+#include "searchpattern.h"
+
+//******************************************************************************************************
+/*!
+ *\class SearchCatalogue
+ *\brief Список инструментов, подготовленный для поиска.
+ *
+ * Названия приводятся к верхнему регистру и разбиваются на слова один раз, при загрузке списка.
+ * Слова всех инструментов лежат подряд в одной строке m_text; m_tokenOffsets - начала слов
+ * (последний элемент - конец строки), m_instrumentTokens - первое слово каждого инструмента
+ * (последний элемент - общее число слов). Для каждого слова хранится маска набора символов.
+*/
+//******************************************************************************************************
+
+SearchCatalogue::SearchCatalogue()
+    : m_instruments()
+    , m_text()
+    , m_instrumentTokens()
+    , m_tokenOffsets()
+    , m_tokenCharsets()
+{
+    clear();
+}
+
+void SearchCatalogue::clear()
+{
+    m_instruments.clear();
+    m_text.clear();
+    m_instrumentTokens.clear();
+    m_instrumentTokens << 0;
+    m_tokenOffsets.clear();
+    m_tokenOffsets << 0;
+    m_tokenCharsets.clear();
+}
+
+void SearchCatalogue::setInstruments(const QList<CurrencyInstrument> &instruments)
+{
+    clear();
+    m_instruments = instruments;
+    foreach (const CurrencyInstrument &instrument, m_instruments)
+    {
+        QStringList words = instrument.name.toUpper().split(" ", QString::SkipEmptyParts);
+        foreach (const QString &word, words)
+        {
+            m_text += word;
+            m_tokenOffsets << m_text.length();
+            m_tokenCharsets << SearchPattern::charset(word.constData(), word.length());
+        }
+        m_instrumentTokens << m_tokenCharsets.count();
+    }
+    m_text.squeeze();
+    m_instrumentTokens.squeeze();
+    m_tokenOffsets.squeeze();
+    m_tokenCharsets.squeeze();
+}
+
+bool SearchCatalogue::isEmpty() const
+{
+    return m_instruments.isEmpty();
+}
+
+int SearchCatalogue::count() const
+{
+    return m_instruments.count();
+}
+
+const CurrencyInstrument& SearchCatalogue::instrument(int index) const
+{
+    return m_instruments[index];
+}
+
+int SearchCatalogue::firstToken(int index) const
+{
+    return m_instrumentTokens[index];
+}
+
+int SearchCatalogue::tokenCount(int index) const
+{
+    return m_instrumentTokens[index+1] - m_instrumentTokens[index];
+}
+
+int SearchCatalogue::totalTokenCount() const
+{
+    return m_tokenCharsets.count();
+}
+
+const QChar* SearchCatalogue::tokenData(int token) const
+{
+    return m_text.constData() + m_tokenOffsets[token];
+}
+
+int SearchCatalogue::tokenLength(int token) const
+{
+    return m_tokenOffsets[token+1] - m_tokenOffsets[token];
+}
+
+quint64 SearchCatalogue::tokenCharset(int token) const
+{
+    return m_tokenCharsets[token];
+}
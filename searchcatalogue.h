@@ -0,0 +1,33 @@
+#ifndef SEARCHCATALOGUE_H
+#define SEARCHCATALOGUE_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "currencyinstrument.h"
+
+class SearchCatalogue
+{
+public:
+    SearchCatalogue();
+    void clear();
+    void setInstruments(const QList<CurrencyInstrument> &instruments);
+    bool isEmpty() const;
+    int count() const;
+    const CurrencyInstrument& instrument(int index) const;
+    int firstToken(int index) const;
+    int tokenCount(int index) const;
+    int totalTokenCount() const;
+    const QChar* tokenData(int token) const;
+    int tokenLength(int token) const;
+    quint64 tokenCharset(int token) const;
+
+private:
+    QList<CurrencyInstrument> m_instruments;
+    QString m_text;
+    QVector<int> m_instrumentTokens;
+    QVector<int> m_tokenOffsets;
+    QVector<quint64> m_tokenCharsets;
+};
+
+#endif // SEARCHCATALOGUE_H
@@ -1,6 +1,6 @@
 #include "searchengine.h"
-#include <QDomDocument>
 #include <QVector>
+#include <limits.h>
 
 #include <QDebug>
 
@@ -14,7 +14,10 @@
 SearchEngine::SearchEngine()
     : QObject()
     , SingletonT<SearchEngine>()
-    , m_instruments()
+    , m_catalogue()
+    , m_index()
+    , m_generation(0)
+    , m_parser(NULL)
 {
 }
 
@@ -23,120 +26,165 @@ void SearchEngine::loadInstruments()
     QNetworkAccessManager *manager = new QNetworkAccessManager(this);
     connect(manager, SIGNAL(finished(QNetworkReply*)), this, SLOT(onReplyFinished(QNetworkReply*)));
 
-    manager->get(QNetworkRequest(QUrl("http://www.cbr.ru/scripts/XML_val.asp")));
+    delete m_parser;
+    m_parser = new CurrencyInstrumentReplyParser();
+    QNetworkReply *reply = manager->get(QNetworkRequest(QUrl("http://www.cbr.ru/scripts/XML_val.asp")));
+    connect(reply, SIGNAL(readyRead()), this, SLOT(onReplyReadyRead()));
 }
 
-CurrencyInstrumentRankedMap SearchEngine::variants(const QString &query) const
+// Первые count вариантов и равные последнему из них, от лучшего к худшему.
+// Инструменты сравниваются с запросом в порядке возрастания оценки снизу по n-граммам; как только
+// оценка превышает расстояние count-го найденного варианта, остальные уже не нужны. Расстояние
+// инструмента считается лишь до тех пор, пока не превысит это же значение.
+// Сессия (session) позволяет при дописывании запроса использовать расчёты прошлого запроса.
+QVector<SearchVariant> SearchEngine::topVariants(const QString &query, int count, SearchSession *session) const
 {
-    CurrencyInstrumentRankedMap result;
     QStringList querySentence = query.toUpper().split(" ", QString::SkipEmptyParts);
-    if (!querySentence.isEmpty())
+    SearchSession localSession;
+    if (session == NULL)
+    {
+        session = &localSession;
+    }
+    session->start(querySentence, m_generation, m_catalogue.count());
+    if ((querySentence.isEmpty()) || (count <= 0))
     {
-        int relevance = maximalRelevantDistance(querySentence);
-        foreach (const CurrencyInstrument &instrument, m_instruments)
+        return QVector<SearchVariant>();
+    }
+
+    int relevance = maximalRelevantDistance(querySentence);
+    QVector<int> bounds = m_index.lowerBounds(session->patterns());
+    QVector< QVector<int> > boundBuckets(relevance + 1);
+    for (int i = 0; i < bounds.count(); i++)
+    {
+        int bound = qMax(bounds[i], session->distance(i));
+        if (bound <= relevance)
         {
-            QStringList baseSentence = instrument.name.toUpper().split(" ", QString::SkipEmptyParts);
-            double d = sentenceDistance(querySentence, baseSentence);
-            if (d <= relevance)
-            {
-                result.insert(d, instrument);
-            }
+            boundBuckets[bound] << i;
         }
-
     }
-    return result;
-}
 
-void SearchEngine::onReplyFinished(QNetworkReply *reply)
-{
-    m_instruments.clear();
-
-    QDomDocument doc;
-    if (doc.setContent(reply->readAll()))
+    SearchTopList topList(count);
+    for (int bound = 0; (bound <= relevance) && (bound <= topList.worstDistance()); bound++)
     {
-        QDomElement root = doc.documentElement();
-        for (QDomElement itemElement = root.firstChildElement("Item"); !itemElement.isNull(); itemElement = itemElement.nextSiblingElement("Item"))
+        foreach (int i, boundBuckets[bound])
         {
-            QString id = itemElement.attribute("ID");
-            QString name = itemElement.firstChildElement("Name").text();
-            if ((!id.isEmpty()) && (!name.isEmpty()))
+            int limit = qMin(relevance, topList.worstDistance());
+            if (bound > limit)
+            {
+                break;
+            }
+            int d = sentenceDistance(session, i, limit);
+            if (d <= limit)
             {
-                m_instruments << CurrencyInstrument(id, name);
+                topList.insert(d, i);
             }
         }
     }
+    return topList.variants();
 }
 
-int SearchEngine::wordDistance(const QString &queryWord, const QString &baseWord)
+// Если maximalCount > 0, в результате только первые maximalCount вариантов и равные последнему из них.
+CurrencyInstrumentRankedMap SearchEngine::variants(const QString &query, int maximalCount, SearchSession *session) const
 {
-    if ((queryWord.isEmpty()) || (baseWord.isEmpty()))
+    CurrencyInstrumentRankedMap result;
+    int count = (maximalCount > 0) ? maximalCount : m_catalogue.count();
+    QVector<SearchVariant> rankedVariants = topVariants(query, count, session);
+    // Равные варианты вставляются в порядке каталога - QMultiMap выдаст их в обратном
+    for (int i = rankedVariants.count()-1; i >= 0; i--)
     {
-        return 0;
+        result.insert(rankedVariants[i].distance, m_catalogue.instrument(rankedVariants[i].index));
     }
+    return result;
+}
 
-    typedef QVector<int> IntVector;
-    QList<IntVector> matrix;
-    for (int i = 0; i < queryWord.length()+1; i++)
-    {
-        IntVector row;
-        row.fill(0, baseWord.length()+1);
-        matrix << row;
-    }
-    for (int i = 0; i < queryWord.length()+1; i++)
-    {
-        matrix[i][0] = i;
-    }
-    for (int j = 0; j < baseWord.length()+1; j++)
+const CurrencyInstrument& SearchEngine::instrument(int index) const
+{
+    return m_catalogue.instrument(index);
+}
+
+void SearchEngine::onReplyReadyRead()
+{
+    // Список разбирается по мере поступления данных
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if ((reply != NULL) && (m_parser != NULL))
     {
-        matrix[0][j] = j;
+        m_parser->addData(reply->readAll());
     }
-    for (int i = 1; i < queryWord.length()+1; i++)
+}
+
+void SearchEngine::setInstruments(const QList<CurrencyInstrument> &instruments)
+{
+    // Сессии поиска по прежнему списку больше не годятся
+    m_generation++;
+    // Названия разбиваются на слова здесь, а не при каждом запросе
+    m_catalogue.setInstruments(instruments);
+    m_index.build(m_catalogue);
+}
+
+void SearchEngine::onReplyFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    QList<CurrencyInstrument> instruments;
+    if (m_parser != NULL)
     {
-        for (int j = 1; j < baseWord.length()+1; j++)
+        m_parser->addData(reply->readAll());
+        if (m_parser->finish())
         {
-            int match = (queryWord[i-1] == baseWord[j-1]) ? 0 : 1;
-            matrix[i][j] = qMin(qMin(matrix[i-1][j] + 1, matrix[i][j-1] + 1), matrix[i-1][j-1] + match);
+            instruments = m_parser->instruments();
         }
+        delete m_parser;
+        m_parser = NULL;
     }
-
-    // В отличие от расстояния Левенштейна, берётся не последнее значение последней строки, а минимальное значение
-    // последней строки.
-    IntVector lastRow = matrix.last();
-    int result = lastRow[0];
-    for (int j = 1; j < lastRow.count(); j++)
-    {
-        result = qMin(result, lastRow[j]);
-    }
-    return result;
+    setInstruments(instruments);
 }
 
-int SearchEngine::wordInSentenceDistance(const QStringList &querySentence, const QStringList &baseSentence, int queryWordIndex, int baseWordIndex)
+int SearchEngine::wordDistance(const SearchPattern &queryWord, int queryWordIndex, int instrumentIndex) const
 {
-    int result = wordDistance(querySentence[queryWordIndex], baseSentence[baseWordIndex]);
-    if (queryWordIndex != baseWordIndex)
+    // Расстояние до лучшего слова инструмента; инструмент без слов совпадает с любым запросом
+    int firstToken = m_catalogue.firstToken(instrumentIndex);
+    int tokenCount = m_catalogue.tokenCount(instrumentIndex);
+    if (tokenCount == 0)
+    {
+        return 0;
+    }
+    int result = INT_MAX;
+    for (int j = 0; j < tokenCount; j++)
     {
+        int token = firstToken + j;
+        int tokenLength = m_catalogue.tokenLength(token);
         // Несовпадение позиций слов карается штрафом +1
-        result++;
+        int penalty = (queryWordIndex != j) ? 1 : 0;
+        // Слово, которое по оценке снизу не лучше найденного, не сравнивается
+        if (queryWord.lowerBound(m_catalogue.tokenCharset(token), tokenLength) + penalty >= result)
+        {
+            continue;
+        }
+        result = qMin(result, queryWord.distance(m_catalogue.tokenData(token), tokenLength) + penalty);
     }
     return result;
 }
 
-int SearchEngine::sentenceDistance(const QStringList &querySentence, const QStringList &baseSentence)
+int SearchEngine::sentenceDistance(SearchSession *session, int instrumentIndex, int limit) const
 {
-    if ((querySentence.isEmpty()) || (baseSentence.isEmpty()))
-    {
-        return 0;
-    }
-    int result = 0;
-    for (int i = 0; i < querySentence.length(); i++)
+    // Результат больше limit может быть неточным (но не больше точного): дальше считать незачем.
+    // Сумма по всем словам, кроме последнего, считается точно и запоминается в сессии.
+    const QList<SearchPattern> &querySentence = session->patterns();
+    int lastIndex = querySentence.count() - 1;
+    int result = session->prefixDistance(instrumentIndex);
+    if (result < 0)
     {
-        int bestWordDistance = wordInSentenceDistance(querySentence, baseSentence, i, 0);
-        for (int j = 0; j < baseSentence.count(); j++)
+        result = 0;
+        for (int i = 0; i < lastIndex; i++)
         {
-            bestWordDistance = qMin(bestWordDistance, wordInSentenceDistance(querySentence, baseSentence, i, j));
+            result += wordDistance(querySentence[i], i, instrumentIndex);
         }
-        result += bestWordDistance;
+        session->setPrefixDistance(instrumentIndex, result);
+    }
+    if (result <= limit)
+    {
+        result += wordDistance(querySentence[lastIndex], lastIndex, instrumentIndex);
     }
+    session->setDistance(instrumentIndex, result);
     return result;
 }
 
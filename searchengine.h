@@ -7,6 +7,12 @@
 #include <QStringList>
 #include "singletont.h"
 #include "currencyinstrument.h"
+#include "currencyreplyparser.h"
+#include "searchcatalogue.h"
+#include "searchngramindex.h"
+#include "searchpattern.h"
+#include "searchsession.h"
+#include "searchtoplist.h"
 
 typedef QMultiMap<double,CurrencyInstrument> CurrencyInstrumentRankedMap;
 
@@ -17,16 +23,22 @@ class SearchEngine : public QObject, public SingletonT<SearchEngine>
 public:
     SearchEngine();
     void loadInstruments();
-    CurrencyInstrumentRankedMap variants(const QString &query) const;
+    void setInstruments(const QList<CurrencyInstrument> &instruments);
+    QVector<SearchVariant> topVariants(const QString &query, int count, SearchSession *session = NULL) const;
+    CurrencyInstrumentRankedMap variants(const QString &query, int maximalCount = 0, SearchSession *session = NULL) const;
+    const CurrencyInstrument& instrument(int index) const;
 
 private slots:
+    void onReplyReadyRead();
     void onReplyFinished(QNetworkReply *reply);
 
 private:
-    QList<CurrencyInstrument> m_instruments;
-    static int wordDistance(const QString &queryWord, const QString &baseWord);
-    static int wordInSentenceDistance(const QStringList &querySentence, const QStringList &baseSentence, int queryWordIndex, int baseWordIndex);
-    static int sentenceDistance(const QStringList &querySentence, const QStringList &baseSentence);
+    SearchCatalogue m_catalogue;
+    SearchNgramIndex m_index;
+    int m_generation;
+    CurrencyInstrumentReplyParser *m_parser;
+    int wordDistance(const SearchPattern &queryWord, int queryWordIndex, int instrumentIndex) const;
+    int sentenceDistance(SearchSession *session, int instrumentIndex, int limit) const;
     static int maximalRelevantDistance(const QStringList &querySentence);
 };
 
@@ -4,6 +4,8 @@
 
 #include <QDebug>
 
+static const int MaximalVariantCount = 4;
+
 //******************************************************************************************************
 /*!
  *\class SearchInput
@@ -15,6 +17,7 @@ SearchInput::SearchInput(QWidget *parent)
     : QLineEdit(parent)
     , m_highlight(NULL)
     , m_instrument()
+    , m_session()
 {
     connect(this, SIGNAL(textEdited(QString)), this, SLOT(onTextEdited(QString)));
     m_highlight = new SearchInputHighlight(this);
@@ -51,24 +54,13 @@ void SearchInput::onTextEdited(const QString &text)
     // Запрос (текст без пробелов спереди и сзади)
     QString query = text.trimmed();
 
-    // Получение всех вариантов
-    CurrencyInstrumentRankedMap allVariants = SearchEngine::instance()->variants(query);
-
-    // Ограничение вариантов (4 штуки with ties)
+    // Лучшие варианты (MaximalVariantCount штук with ties)
+    SearchEngine *engine = SearchEngine::instance();
+    QVector<SearchVariant> topVariants = engine->topVariants(query, MaximalVariantCount, &m_session);
     QList<CurrencyInstrument> croppedVariants;
-    int lastRank = 0;
-    for (auto iter = allVariants.constBegin(); iter != allVariants.constEnd(); ++iter)
+    foreach (const SearchVariant &variant, topVariants)
     {
-        double rank = iter.key();
-        if ((croppedVariants.count() < 4) || (rank == lastRank))
-        {
-            croppedVariants << iter.value();
-        }
-        else
-        {
-            break;
-        }
-        lastRank = rank;
+        croppedVariants << engine->instrument(variant.index);
     }
 
     QPoint hightlightPos = mapToGlobal(QPoint(0, 0)) + QPoint(0, height());
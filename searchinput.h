@@ -3,6 +3,7 @@
 
 #include <QLineEdit>
 #include "searchengine.h"
+#include "searchsession.h"
 
 class SearchInputHighlight;
 
@@ -27,6 +28,7 @@ private slots:
 private:
     SearchInputHighlight *m_highlight;
     CurrencyInstrument m_instrument;
+    SearchSession m_session;
     void setInstrument(const CurrencyInstrument &value);
     void takeHighlightedInstrument();
 };
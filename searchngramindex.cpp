@@ -0,0 +1,222 @@
+#include "searchngramindex.h"
+
+static const int MinimalGramLength = 2;
+static const int MaximalGramLength = 3;
+
+//******************************************************************************************************
+/*!
+ *\struct SearchNgramPosting
+ *\brief Вхождение n-граммы в слово каталога: номер слова и число повторов.
+*/
+//******************************************************************************************************
+
+SearchNgramPosting::SearchNgramPosting()
+    : token(-1)
+    , count(0)
+{
+
+}
+
+SearchNgramPosting::SearchNgramPosting(int aToken, int aCount)
+    : token(aToken)
+    , count(aCount)
+{
+
+}
+
+
+//******************************************************************************************************
+/*!
+ *\class SearchNgramIndex
+ *\brief Инвертированный индекс биграмм и триграмм слов каталога.
+ *
+ * Индекс даёт для каждого инструмента оценку снизу расстояния sentenceDistance() до запроса.
+ * Если слово запроса длины m отличается от начала слова каталога не более чем на k правок,
+ * у них не менее (m - q + 1) - k*q общих q-грамм (каждая правка портит не больше q из них).
+ * Отсюда k >= ceil((m - q + 1 - shared) / q), где shared - число общих q-грамм с лучшим словом
+ * инструмента. Оценки слов запроса складываются.
+*/
+//******************************************************************************************************
+
+SearchNgramIndex::SearchNgramIndex()
+    : m_instrumentCount(0)
+    , m_tokenInstruments()
+    , m_emptyInstruments()
+    , m_postings()
+{
+
+}
+
+void SearchNgramIndex::clear()
+{
+    m_instrumentCount = 0;
+    m_tokenInstruments.clear();
+    m_emptyInstruments.clear();
+    m_postings.clear();
+}
+
+void SearchNgramIndex::build(const SearchCatalogue &catalogue)
+{
+    clear();
+    m_instrumentCount = catalogue.count();
+    m_tokenInstruments.resize(catalogue.totalTokenCount());
+    for (int instrumentIndex = 0; instrumentIndex < catalogue.count(); instrumentIndex++)
+    {
+        int firstToken = catalogue.firstToken(instrumentIndex);
+        int tokenCount = catalogue.tokenCount(instrumentIndex);
+        if (tokenCount == 0)
+        {
+            m_emptyInstruments << instrumentIndex;
+        }
+        for (int token = firstToken; token < firstToken + tokenCount; token++)
+        {
+            m_tokenInstruments[token] = instrumentIndex;
+            for (int gramLength = MinimalGramLength; gramLength <= MaximalGramLength; gramLength++)
+            {
+                QHash<quint64, int> tokenGrams = grams(catalogue.tokenData(token), catalogue.tokenLength(token), gramLength);
+                for (auto iter = tokenGrams.constBegin(); iter != tokenGrams.constEnd(); ++iter)
+                {
+                    m_postings[iter.key()] << SearchNgramPosting(token, iter.value());
+                }
+            }
+        }
+    }
+    for (auto iter = m_postings.begin(); iter != m_postings.end(); ++iter)
+    {
+        iter.value().squeeze();
+    }
+}
+
+int SearchNgramIndex::instrumentCount() const
+{
+    return m_instrumentCount;
+}
+
+QVector<int> SearchNgramIndex::lowerBounds(const QList<SearchPattern> &querySentence) const
+{
+    // Сначала всем инструментам назначается оценка "ни одной общей n-граммы",
+    // затем для инструментов из списков вхождений она уменьшается.
+    QVector<int> result(m_instrumentCount, 0);
+    int untouchedTotal = 0;
+    QVector<int> sharedByToken(m_tokenInstruments.count(), 0);
+    QVector<int> sharedByInstrument[MaximalGramLength + 1];
+    for (int gramLength = MinimalGramLength; gramLength <= MaximalGramLength; gramLength++)
+    {
+        sharedByInstrument[gramLength].fill(0, m_instrumentCount);
+    }
+    QVector<int> touchedTokens;
+    QVector<int> touchedInstruments;
+    QVector<bool> isTouched(m_instrumentCount, false);
+
+    foreach (const SearchPattern &queryWord, querySentence)
+    {
+        int untouchedBound = 0;
+        for (int gramLength = MinimalGramLength; gramLength <= MaximalGramLength; gramLength++)
+        {
+            int gramCount = queryWord.length() - gramLength + 1;
+            untouchedBound = qMax(untouchedBound, wordBound(gramCount, 0, gramLength));
+            if (gramCount <= 0)
+            {
+                continue;
+            }
+
+            // Общие n-граммы с каждым словом каталога (пересечение мультимножеств)
+            QHash<quint64, int> queryGrams = grams(queryWord.word().constData(), queryWord.length(), gramLength);
+            for (auto iter = queryGrams.constBegin(); iter != queryGrams.constEnd(); ++iter)
+            {
+                auto postings = m_postings.constFind(iter.key());
+                if (postings == m_postings.constEnd())
+                {
+                    continue;
+                }
+                foreach (const SearchNgramPosting &posting, postings.value())
+                {
+                    if (sharedByToken[posting.token] == 0)
+                    {
+                        touchedTokens << posting.token;
+                    }
+                    sharedByToken[posting.token] += qMin(iter.value(), posting.count);
+                }
+            }
+
+            // Лучшее слово инструмента
+            foreach (int token, touchedTokens)
+            {
+                int instrumentIndex = m_tokenInstruments[token];
+                int &shared = sharedByInstrument[gramLength][instrumentIndex];
+                shared = qMax(shared, sharedByToken[token]);
+                sharedByToken[token] = 0;
+                if (!isTouched[instrumentIndex])
+                {
+                    isTouched[instrumentIndex] = true;
+                    touchedInstruments << instrumentIndex;
+                }
+            }
+            touchedTokens.clear();
+        }
+
+        untouchedTotal += untouchedBound;
+        foreach (int instrumentIndex, touchedInstruments)
+        {
+            int bound = 0;
+            for (int gramLength = MinimalGramLength; gramLength <= MaximalGramLength; gramLength++)
+            {
+                int gramCount = queryWord.length() - gramLength + 1;
+                int &shared = sharedByInstrument[gramLength][instrumentIndex];
+                bound = qMax(bound, wordBound(gramCount, shared, gramLength));
+                shared = 0;
+            }
+            result[instrumentIndex] -= untouchedBound - bound;
+            isTouched[instrumentIndex] = false;
+        }
+        touchedInstruments.clear();
+    }
+
+    for (int i = 0; i < m_instrumentCount; i++)
+    {
+        result[i] += untouchedTotal;
+    }
+    // Инструмент без слов совпадает с любым запросом (см. SearchEngine::sentenceDistance)
+    foreach (int instrumentIndex, m_emptyInstruments)
+    {
+        result[instrumentIndex] = 0;
+    }
+    return result;
+}
+
+int SearchNgramIndex::minimalGramLength()
+{
+    return MinimalGramLength;
+}
+
+int SearchNgramIndex::maximalGramLength()
+{
+    return MaximalGramLength;
+}
+
+quint64 SearchNgramIndex::gramKey(const QChar *text, int gramLength)
+{
+    // Длина n-граммы занимает старшие биты, чтобы ключи биграмм и триграмм не пересекались
+    quint64 result = quint64(gramLength) << 48;
+    for (int i = 0; i < gramLength; i++)
+    {
+        result |= quint64(text[i].unicode()) << (16 * i);
+    }
+    return result;
+}
+
+QHash<quint64, int> SearchNgramIndex::grams(const QChar *text, int textLength, int gramLength)
+{
+    QHash<quint64, int> result;
+    for (int i = 0; i + gramLength <= textLength; i++)
+    {
+        result[gramKey(text + i, gramLength)]++;
+    }
+    return result;
+}
+
+int SearchNgramIndex::wordBound(int gramCount, int sharedCount, int gramLength)
+{
+    int missing = gramCount - sharedCount;
+    return (missing > 0) ? (missing + gramLength - 1) / gramLength : 0;
+}
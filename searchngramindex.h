@@ -0,0 +1,39 @@
+#ifndef SEARCHNGRAMINDEX_H
+#define SEARCHNGRAMINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include "searchcatalogue.h"
+#include "searchpattern.h"
+
+struct SearchNgramPosting
+{
+    int token;
+    int count;
+    SearchNgramPosting();
+    SearchNgramPosting(int aToken, int aCount);
+};
+
+class SearchNgramIndex
+{
+public:
+    SearchNgramIndex();
+    void clear();
+    void build(const SearchCatalogue &catalogue);
+    int instrumentCount() const;
+    QVector<int> lowerBounds(const QList<SearchPattern> &querySentence) const;
+    static int minimalGramLength();
+    static int maximalGramLength();
+
+private:
+    int m_instrumentCount;
+    QVector<int> m_tokenInstruments;
+    QVector<int> m_emptyInstruments;
+    QHash<quint64, QVector<SearchNgramPosting> > m_postings;
+    static quint64 gramKey(const QChar *text, int gramLength);
+    static QHash<quint64, int> grams(const QChar *text, int textLength, int gramLength);
+    static int wordBound(int gramCount, int sharedCount, int gramLength);
+};
+
+#endif // SEARCHNGRAMINDEX_H
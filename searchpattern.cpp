@@ -0,0 +1,206 @@
+#include "searchpattern.h"
+
+static const int MaximalBitLength = 64;
+
+//******************************************************************************************************
+/*!
+ *\class SearchPattern
+ *\brief Слово запроса, подготовленное для быстрого нечёткого сравнения со словами инструментов.
+ *
+ * Расстояние - минимальное значение последней строки матрицы Левенштейна (слово запроса против
+ * начала слова инструмента). Для слов до 64 символов оно считается бит-параллельным алгоритмом
+ * Майерса в варианте Хюрё: столбец матрицы хранится как два 64-битных вектора приращений,
+ * маски символов слова запроса строятся один раз в конструкторе. Более длинные слова считаются
+ * обычной матрицей.
+ *
+ * Набор символов слова - 64-битная маска (бит на символ по модулю 64). По маске и длине слова
+ * инструмента lowerBound() даёт оценку расстояния снизу, не строя матрицу.
+*/
+//******************************************************************************************************
+
+SearchPattern::SearchPattern()
+    : m_word()
+    , m_chars()
+    , m_masks()
+    , m_charsetBits()
+    , m_charsetCounts()
+{
+
+}
+
+SearchPattern::SearchPattern(const QString &word)
+    : m_word(word)
+    , m_chars()
+    , m_masks()
+    , m_charsetBits()
+    , m_charsetCounts()
+{
+    for (int i = 0; i < m_word.length(); i++)
+    {
+        quint64 bit = charsetBit(m_word[i]);
+        int index = m_charsetBits.indexOf(bit);
+        if (index < 0)
+        {
+            index = m_charsetBits.count();
+            m_charsetBits << bit;
+            m_charsetCounts << 0;
+        }
+        m_charsetCounts[index]++;
+    }
+    if (m_word.length() <= MaximalBitLength)
+    {
+        for (int i = 0; i < m_word.length(); i++)
+        {
+            int index = m_chars.indexOf(m_word[i]);
+            if (index < 0)
+            {
+                index = m_chars.count();
+                m_chars << m_word[i];
+                m_masks << 0;
+            }
+            m_masks[index] |= quint64(1) << i;
+        }
+    }
+}
+
+const QString& SearchPattern::word() const
+{
+    return m_word;
+}
+
+int SearchPattern::length() const
+{
+    return m_word.length();
+}
+
+bool SearchPattern::isEmpty() const
+{
+    return m_word.isEmpty();
+}
+
+int SearchPattern::distance(const QChar *text, int textLength) const
+{
+    if ((m_word.isEmpty()) || (textLength <= 0))
+    {
+        return 0;
+    }
+    if (m_word.length() <= MaximalBitLength)
+    {
+        return bitDistance(text, textLength);
+    }
+    return matrixDistance(text, textLength);
+}
+
+int SearchPattern::distance(const QString &text) const
+{
+    return distance(text.constData(), text.length());
+}
+
+int SearchPattern::lowerBound(quint64 textCharset, int textLength) const
+{
+    // Символ, которого нет в слове инструмента, нельзя сопоставить - только заменить или удалить.
+    // Кроме того, слово запроса длиннее слова инструмента требует удалений.
+    int missing = 0;
+    for (int i = 0; i < m_charsetBits.count(); i++)
+    {
+        if ((textCharset & m_charsetBits[i]) == 0)
+        {
+            missing += m_charsetCounts[i];
+        }
+    }
+    return qMax(missing, m_word.length() - textLength);
+}
+
+int SearchPattern::maximalBitLength()
+{
+    return MaximalBitLength;
+}
+
+quint64 SearchPattern::charsetBit(QChar c)
+{
+    return quint64(1) << (c.unicode() % 64);
+}
+
+quint64 SearchPattern::charset(const QChar *text, int textLength)
+{
+    quint64 result = 0;
+    for (int i = 0; i < textLength; i++)
+    {
+        result |= charsetBit(text[i]);
+    }
+    return result;
+}
+
+quint64 SearchPattern::charMask(QChar c) const
+{
+    for (int i = 0; i < m_chars.count(); i++)
+    {
+        if (m_chars[i] == c)
+        {
+            return m_masks[i];
+        }
+    }
+    return 0;
+}
+
+int SearchPattern::bitDistance(const QChar *text, int textLength) const
+{
+    // Pv/Mv - положительные/отрицательные вертикальные приращения текущего столбца,
+    // score - значение в последней строке. Первая строка матрицы равна j, поэтому
+    // горизонтальное приращение над ней всегда +1 (единица вдвигается в Ph).
+    const quint64 lastBit = quint64(1) << (m_word.length() - 1);
+    quint64 pv = ~quint64(0);
+    quint64 mv = 0;
+    int score = m_word.length();
+    int result = score;
+    for (int j = 0; j < textLength; j++)
+    {
+        quint64 eq = charMask(text[j]);
+        quint64 xv = eq | mv;
+        quint64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        quint64 ph = mv | ~(xh | pv);
+        quint64 mh = pv & xh;
+        if (ph & lastBit)
+        {
+            score++;
+        }
+        else if (mh & lastBit)
+        {
+            score--;
+        }
+        ph = (ph << 1) | 1;
+        mh = mh << 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        result = qMin(result, score);
+    }
+    return result;
+}
+
+int SearchPattern::matrixDistance(const QChar *text, int textLength) const
+{
+    // Та же матрица построчно; хранится только одна строка
+    QVector<int> row(textLength + 1);
+    for (int j = 0; j <= textLength; j++)
+    {
+        row[j] = j;
+    }
+    for (int i = 1; i <= m_word.length(); i++)
+    {
+        int diagonal = row[0];
+        row[0] = i;
+        for (int j = 1; j <= textLength; j++)
+        {
+            int match = (m_word[i-1] == text[j-1]) ? 0 : 1;
+            int value = qMin(qMin(row[j] + 1, row[j-1] + 1), diagonal + match);
+            diagonal = row[j];
+            row[j] = value;
+        }
+    }
+    int result = row[0];
+    for (int j = 1; j <= textLength; j++)
+    {
+        result = qMin(result, row[j]);
+    }
+    return result;
+}
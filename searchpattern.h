@@ -0,0 +1,33 @@
+#ifndef SEARCHPATTERN_H
+#define SEARCHPATTERN_H
+
+#include <QString>
+#include <QVector>
+
+class SearchPattern
+{
+public:
+    SearchPattern();
+    explicit SearchPattern(const QString &word);
+    const QString& word() const;
+    int length() const;
+    bool isEmpty() const;
+    int distance(const QChar *text, int textLength) const;
+    int distance(const QString &text) const;
+    int lowerBound(quint64 textCharset, int textLength) const;
+    static int maximalBitLength();
+    static quint64 charsetBit(QChar c);
+    static quint64 charset(const QChar *text, int textLength);
+
+private:
+    QString m_word;
+    QVector<QChar> m_chars;
+    QVector<quint64> m_masks;
+    QVector<quint64> m_charsetBits;
+    QVector<int> m_charsetCounts;
+    quint64 charMask(QChar c) const;
+    int bitDistance(const QChar *text, int textLength) const;
+    int matrixDistance(const QChar *text, int textLength) const;
+};
+
+#endif // SEARCHPATTERN_H
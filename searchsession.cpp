@@ -0,0 +1,112 @@
+#include "searchsession.h"
+
+//******************************************************************************************************
+/*!
+ *\class SearchSession
+ *\brief Состояние поиска между нажатиями клавиш.
+ *
+ * Пока пользователь дописывает последнее слово запроса, от прошлого запроса остаются:
+ * - маски символов неизменных слов;
+ * - сумма расстояний по всем словам, кроме последнего (m_prefixDistances) - её не нужно пересчитывать;
+ * - прошлые расстояния (m_distances): от дописывания символа расстояние не уменьшается, поэтому
+ *   прошлое значение - оценка снизу нового.
+ * Любая другая правка (удаление, вставка в середину, новое слово) начинает сессию заново.
+ * Значение -1 означает, что расстояние для инструмента ещё не считалось.
+*/
+//******************************************************************************************************
+
+SearchSession::SearchSession()
+    : m_generation(-1)
+    , m_querySentence()
+    , m_patterns()
+    , m_prefixDistances()
+    , m_distances()
+    , m_incremental(false)
+{
+
+}
+
+void SearchSession::reset()
+{
+    m_generation = -1;
+    m_querySentence.clear();
+    m_patterns.clear();
+    m_prefixDistances.clear();
+    m_distances.clear();
+    m_incremental = false;
+}
+
+void SearchSession::start(const QStringList &querySentence, int generation, int instrumentCount)
+{
+    m_incremental =
+            (generation == m_generation) &&
+            (m_distances.count() == instrumentCount) &&
+            (isExtension(m_querySentence, querySentence));
+    if (m_incremental)
+    {
+        if (m_querySentence.last() != querySentence.last())
+        {
+            m_patterns.last() = SearchPattern(querySentence.last());
+        }
+    }
+    else
+    {
+        m_patterns.clear();
+        foreach (const QString &queryWord, querySentence)
+        {
+            m_patterns << SearchPattern(queryWord);
+        }
+        m_prefixDistances.fill(-1, instrumentCount);
+        m_distances.fill(-1, instrumentCount);
+    }
+    m_generation = generation;
+    m_querySentence = querySentence;
+}
+
+bool SearchSession::isIncremental() const
+{
+    return m_incremental;
+}
+
+const QList<SearchPattern>& SearchSession::patterns() const
+{
+    return m_patterns;
+}
+
+int SearchSession::prefixDistance(int instrumentIndex) const
+{
+    return m_prefixDistances[instrumentIndex];
+}
+
+void SearchSession::setPrefixDistance(int instrumentIndex, int value)
+{
+    m_prefixDistances[instrumentIndex] = value;
+}
+
+int SearchSession::distance(int instrumentIndex) const
+{
+    return m_distances[instrumentIndex];
+}
+
+void SearchSession::setDistance(int instrumentIndex, int value)
+{
+    m_distances[instrumentIndex] = value;
+}
+
+bool SearchSession::isExtension(const QStringList &previousSentence, const QStringList &querySentence)
+{
+    // Те же слова, последнее - дописано (или не изменилось)
+    if ((previousSentence.isEmpty()) || (previousSentence.count() != querySentence.count()))
+    {
+        return false;
+    }
+    int lastIndex = querySentence.count() - 1;
+    for (int i = 0; i < lastIndex; i++)
+    {
+        if (previousSentence[i] != querySentence[i])
+        {
+            return false;
+        }
+    }
+    return querySentence[lastIndex].startsWith(previousSentence[lastIndex]);
+}
@@ -0,0 +1,32 @@
+#ifndef SEARCHSESSION_H
+#define SEARCHSESSION_H
+
+#include <QList>
+#include <QStringList>
+#include <QVector>
+#include "searchpattern.h"
+
+class SearchSession
+{
+public:
+    SearchSession();
+    void reset();
+    void start(const QStringList &querySentence, int generation, int instrumentCount);
+    bool isIncremental() const;
+    const QList<SearchPattern>& patterns() const;
+    int prefixDistance(int instrumentIndex) const;
+    void setPrefixDistance(int instrumentIndex, int value);
+    int distance(int instrumentIndex) const;
+    void setDistance(int instrumentIndex, int value);
+
+private:
+    int m_generation;
+    QStringList m_querySentence;
+    QList<SearchPattern> m_patterns;
+    QVector<int> m_prefixDistances;
+    QVector<int> m_distances;
+    bool m_incremental;
+    static bool isExtension(const QStringList &previousSentence, const QStringList &querySentence);
+};
+
+#endif // SEARCHSESSION_H
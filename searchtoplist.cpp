@@ -0,0 +1,125 @@
+#include "searchtoplist.h"
+#include <algorithm>
+#include <limits.h>
+
+static bool isNearer(const SearchVariant &first, const SearchVariant &second)
+{
+    return first.distance < second.distance;
+}
+
+static bool isBefore(const SearchVariant &first, const SearchVariant &second)
+{
+    // Равные варианты - в обратном порядке каталога (так их выдавал QMultiMap)
+    if (first.distance != second.distance)
+    {
+        return first.distance < second.distance;
+    }
+    return first.index > second.index;
+}
+
+//******************************************************************************************************
+/*!
+ *\struct SearchVariant
+ *\brief Вариант поиска: расстояние до запроса и номер инструмента в каталоге.
+*/
+//******************************************************************************************************
+
+SearchVariant::SearchVariant()
+    : distance(0)
+    , index(-1)
+{
+
+}
+
+SearchVariant::SearchVariant(int aDistance, int anIndex)
+    : distance(aDistance)
+    , index(anIndex)
+{
+
+}
+
+
+//******************************************************************************************************
+/*!
+ *\class SearchTopList
+ *\brief Первые capacity() вариантов поиска и варианты, равные последнему из них.
+ *
+ * Лучшие варианты хранятся в куче фиксированного размера с худшим вариантом наверху.
+ * Варианты с тем же расстоянием, что у худшего, но не поместившиеся в кучу, хранятся отдельно
+ * (m_ties); когда худшее расстояние в куче уменьшается, они отбрасываются.
+*/
+//******************************************************************************************************
+
+SearchTopList::SearchTopList(int capacity)
+    : m_capacity(qMax(capacity, 0))
+    , m_heap()
+    , m_ties()
+{
+    m_heap.reserve(m_capacity);
+}
+
+void SearchTopList::clear()
+{
+    m_heap.clear();
+    m_ties.clear();
+}
+
+int SearchTopList::capacity() const
+{
+    return m_capacity;
+}
+
+bool SearchTopList::isFull() const
+{
+    return m_heap.count() >= m_capacity;
+}
+
+int SearchTopList::worstDistance() const
+{
+    // Пока список не заполнен, подходит вариант с любым расстоянием
+    if ((!isFull()) || (m_heap.isEmpty()))
+    {
+        return (m_capacity > 0) ? INT_MAX : -1;
+    }
+    return m_heap.first().distance;
+}
+
+void SearchTopList::insert(int distance, int index)
+{
+    if (m_capacity <= 0)
+    {
+        return;
+    }
+    SearchVariant variant(distance, index);
+    if (!isFull())
+    {
+        m_heap << variant;
+        std::push_heap(m_heap.begin(), m_heap.end(), isNearer);
+    }
+    else if (distance < worstDistance())
+    {
+        std::pop_heap(m_heap.begin(), m_heap.end(), isNearer);
+        SearchVariant worst = m_heap.last();
+        m_heap.last() = variant;
+        std::push_heap(m_heap.begin(), m_heap.end(), isNearer);
+        if (worst.distance == worstDistance())
+        {
+            m_ties << worst;
+        }
+        else
+        {
+            m_ties.clear();
+        }
+    }
+    else if (distance == worstDistance())
+    {
+        m_ties << variant;
+    }
+}
+
+QVector<SearchVariant> SearchTopList::variants() const
+{
+    QVector<SearchVariant> result = m_heap + m_ties;
+    std::sort(result.begin(), result.end(), isBefore);
+    return result;
+}
@@ -0,0 +1,31 @@
+#ifndef SEARCHTOPLIST_H
+#define SEARCHTOPLIST_H
+
+#include <QVector>
+
+struct SearchVariant
+{
+    int distance;
+    int index;
+    SearchVariant();
+    SearchVariant(int aDistance, int anIndex);
+};
+
+class SearchTopList
+{
+public:
+    explicit SearchTopList(int capacity);
+    void clear();
+    int capacity() const;
+    bool isFull() const;
+    int worstDistance() const;
+    void insert(int distance, int index);
+    QVector<SearchVariant> variants() const;
+
+private:
+    int m_capacity;
+    QVector<SearchVariant> m_heap;
+    QVector<SearchVariant> m_ties;
+};
+
+#endif // SEARCHTOPLIST_H
@@ -0,0 +1,183 @@
+#include "skylinepacker.h"
+
+//******************************************************************************************************
+/*!
+ *\class SkylinePacker
+ *\brief Упаковщик прямоугольников (в ячейках сетки) по алгоритму "skyline bottom-left".
+ *
+ * Занятая часть области описывается "линией горизонта" - набором отрезков, для каждого из которых
+ * известна первая свободная строка. Прямоугольник ставится туда, где его верхний край окажется выше
+ * всего, при равенстве - левее. Высота области может быть неограниченной (binHeight <= 0).
+*/
+//******************************************************************************************************
+
+SkylinePacker::Node::Node()
+    :x(0)
+    ,y(0)
+    ,width(0)
+{
+}
+
+SkylinePacker::Node::Node(int aX, int aY, int aWidth)
+    :x(aX)
+    ,y(aY)
+    ,width(aWidth)
+{
+}
+
+SkylinePacker::SkylinePacker()
+    :m_skyline()
+    ,m_binWidth(0)
+    ,m_binHeight(0)
+{
+}
+
+SkylinePacker::SkylinePacker(int binWidth, int binHeight)
+    :m_skyline()
+    ,m_binWidth(0)
+    ,m_binHeight(0)
+{
+    reset(binWidth, binHeight);
+}
+
+void SkylinePacker::reset(int binWidth, int binHeight)
+{
+    m_binWidth = qMax(binWidth, 0);
+    m_binHeight = binHeight;
+    m_skyline.clear();
+    if (m_binWidth > 0)
+    {
+        m_skyline << Node(0, 0, m_binWidth);
+    }
+}
+
+int SkylinePacker::binWidth() const
+{
+    return m_binWidth;
+}
+
+int SkylinePacker::binHeight() const
+{
+    return m_binHeight;
+}
+
+int SkylinePacker::usedHeight() const
+{
+    int result = 0;
+    foreach (const Node &node, m_skyline)
+    {
+        result = qMax(result, node.y);
+    }
+    return result;
+}
+
+void SkylinePacker::occupy(const QRect &rect)
+{
+    QRect r = rect.intersected(QRect(0, 0, m_binWidth, rect.bottom() + 1));
+    if (!r.isEmpty())
+    {
+        raise(r.left(), r.width(), r.bottom() + 1);
+    }
+}
+
+bool SkylinePacker::findPosition(const QSize &size, QPoint &position) const
+{
+    if ((size.width() <= 0) || (size.height() <= 0) || (size.width() > m_binWidth))
+    {
+        return false;
+    }
+
+    int bestY = -1;
+    int bestX = -1;
+    for (int i = 0; i < m_skyline.count(); i++)
+    {
+        int y = fitY(i, size.width());
+        if ((y < 0) || ((m_binHeight > 0) && (y + size.height() > m_binHeight)))
+        {
+            continue;
+        }
+        if ((bestY < 0) || (y < bestY))
+        {
+            bestY = y;
+            bestX = m_skyline[i].x;
+        }
+    }
+
+    if (bestY < 0)
+    {
+        return false;
+    }
+    position = QPoint(bestX, bestY);
+    return true;
+}
+
+bool SkylinePacker::insert(const QSize &size, QRect &rect)
+{
+    QPoint position;
+    if (!findPosition(size, position))
+    {
+        return false;
+    }
+    rect = QRect(position, size);
+    raise(position.x(), size.width(), position.y() + size.height());
+    return true;
+}
+
+int SkylinePacker::fitY(int index, int width) const
+{
+    // Первая свободная строка для прямоугольника шириной width, левый край которого совпадает с отрезком index
+    int x = m_skyline[index].x;
+    if (x + width > m_binWidth)
+    {
+        return -1;
+    }
+    int result = 0;
+    int remainWidth = width;
+    for (int i = index; (i < m_skyline.count()) && (remainWidth > 0); i++)
+    {
+        result = qMax(result, m_skyline[i].y);
+        remainWidth -= m_skyline[i].width;
+    }
+    return result;
+}
+
+void SkylinePacker::raise(int x, int width, int y)
+{
+    // Поднимаем линию горизонта на участке [x, x + width) до строки y (там, где она ниже)
+    QVector<Node> skyline;
+    skyline.reserve(m_skyline.count() + 2);
+    foreach (const Node &node, m_skyline)
+    {
+        int nodeRight = node.x + node.width;
+        int left = qMax(node.x, x);
+        int right = qMin(nodeRight, x + width);
+        if (left >= right)
+        {
+            skyline << node;
+            continue;
+        }
+        if (node.x < left)
+        {
+            skyline << Node(node.x, node.y, left - node.x);
+        }
+        skyline << Node(left, qMax(node.y, y), right - left);
+        if (right < nodeRight)
+        {
+            skyline << Node(right, node.y, nodeRight - right);
+        }
+    }
+
+    // Сливаем соседние отрезки одной высоты
+    m_skyline.clear();
+    foreach (const Node &node, skyline)
+    {
+        if ((!m_skyline.isEmpty()) && (m_skyline.last().y == node.y))
+        {
+            m_skyline.last().width += node.width;
+        }
+        else
+        {
+            m_skyline << node;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef SKYLINEPACKER_H
+#define SKYLINEPACKER_H
+
+#include <QVector>
+#include <QRect>
+#include <QSize>
+#include <QPoint>
+
+class SkylinePacker
+{
+public:
+    SkylinePacker();
+    SkylinePacker(int binWidth, int binHeight);
+    void reset(int binWidth, int binHeight);
+    int binWidth() const;
+    int binHeight() const;
+    int usedHeight() const;
+    void occupy(const QRect &rect);
+    bool findPosition(const QSize &size, QPoint &position) const;
+    bool insert(const QSize &size, QRect &rect);
+
+private:
+    struct Node
+    {
+        int x;
+        int y;
+        int width;
+        Node();
+        Node(int aX, int aY, int aWidth);
+    };
+    QVector<Node> m_skyline;
+    int m_binWidth;
+    int m_binHeight;
+    int fitY(int index, int width) const;
+    void raise(int x, int width, int y);
+};
+
+#endif // SKYLINEPACKER_H
@@ -0,0 +1,202 @@
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QTextStream>
+#include <QDir>
+#include <QtConcurrent>
+#include "chartlabelcache.h"
+#include "currencychartrenderer.h"
+#include "currencychartstore.h"
+#include "currencyreplyparser.h"
+#include "design.h"
+
+// Пакетная отрисовка графиков валют в PNG без открытия окон.
+//
+// TadraRender [--size 640x400] [--output dir] [--jobs N] [--url http://host/XML_dynamic.asp] [--store dir] ID[=file] ...
+//
+// Данные для инструмента берутся из указанного файла хранилища (формат CurrencyChartStore),
+// иначе - по адресу --url (сервер ЦБ РФ или его локальная замена), иначе - из хранилища Tadra.
+
+struct RenderJob
+{
+    QString instrumentId;
+    QString outputFileName;
+    CurrencyChartRenderer renderer;
+    bool ok;
+    RenderJob();
+};
+
+RenderJob::RenderJob()
+    : instrumentId()
+    , outputFileName()
+    , renderer()
+    , ok(false)
+{
+
+}
+
+static bool downloadTable(QNetworkAccessManager *manager, const QString &baseUrl, const QString &instrumentId, CurrencyChartTable &table)
+{
+    QDate firstDate = QDate::currentDate().addMonths(-12).addDays(2);
+    QDate lastDate = QDate::currentDate().addDays(1);
+    QString url = QString("%1?date_req1=%2&date_req2=%3&VAL_NM_RQ=%4")
+            .arg(baseUrl)
+            .arg(firstDate.toString("dd/MM/yyyy"))
+            .arg(lastDate.toString("dd/MM/yyyy"))
+            .arg(instrumentId);
+
+    QNetworkReply *reply = manager->get(QNetworkRequest(QUrl(url)));
+    QEventLoop loop;
+    QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
+    loop.exec();
+
+    CurrencyChartReplyParser parser;
+    parser.addData(reply->readAll());
+    bool result = (reply->error() == QNetworkReply::NoError) && (parser.finish());
+    table = parser.table();
+    table.sortByDate();
+    reply->deleteLater();
+    return result;
+}
+
+static void renderJob(RenderJob &job)
+{
+    QImage image = job.renderer.render(1);
+    job.ok = (!image.isNull()) && (image.save(job.outputFileName, "PNG"));
+}
+
+int main(int argc, char *argv[])
+{
+    // Окна не нужны: если платформа не задана явно, используется offscreen
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    // То же имя, что и у Tadra, - чтобы по умолчанию читать её хранилище
+    QGuiApplication::setApplicationName("Tadra");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders currency charts to PNG files.");
+    parser.addHelpOption();
+    QCommandLineOption sizeOption("size", "Chart size in pixels.", "WxH", "640x400");
+    QCommandLineOption outputOption("output", "Output directory.", "dir", ".");
+    QCommandLineOption jobsOption("jobs", "Number of rendering threads.", "N");
+    QCommandLineOption urlOption("url", "XML_dynamic.asp address for instruments without a series file.", "url");
+    QCommandLineOption storeOption("store", "Series store directory.", "dir");
+    parser.addOption(sizeOption);
+    parser.addOption(outputOption);
+    parser.addOption(jobsOption);
+    parser.addOption(urlOption);
+    parser.addOption(storeOption);
+    parser.addPositionalArgument("instruments", "Instrument ids, optionally with a series file: ID[=file].", "ID[=file]...");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QStringList sizeParts = parser.value(sizeOption).split('x');
+    int width = (sizeParts.count() == 2) ? sizeParts[0].toInt() : 0;
+    int height = (sizeParts.count() == 2) ? sizeParts[1].toInt() : 0;
+    QSizeF minimumSize = CurrencyChartRenderer::minimumSize();
+    if ((width < minimumSize.width()) || (height < minimumSize.height()))
+    {
+        err << "Invalid chart size: " << parser.value(sizeOption) << "\n";
+        return 2;
+    }
+    if (parser.positionalArguments().isEmpty())
+    {
+        parser.showHelp(2);
+    }
+    QDir outputDir(parser.value(outputOption));
+    if (!outputDir.mkpath("."))
+    {
+        err << "Cannot create output directory: " << outputDir.path() << "\n";
+        return 2;
+    }
+    if (parser.isSet(storeOption))
+    {
+        CurrencyChartStore::instance()->setDirectory(parser.value(storeOption));
+    }
+    if (parser.isSet(jobsOption))
+    {
+        QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, parser.value(jobsOption).toInt()));
+    }
+
+    // Загрузка данных и подготовка шкал - в главном потоке, отрисовка - параллельно
+    QNetworkAccessManager manager;
+    QList<RenderJob> jobs;
+    foreach (const QString &argument, parser.positionalArguments())
+    {
+        QString instrumentId = argument.section('=', 0, 0);
+        QString fileName = argument.section('=', 1);
+        CurrencyChartTable table;
+        QDate firstDate;
+        bool loaded = false;
+        if (!fileName.isEmpty())
+        {
+            loaded = CurrencyChartStore::readFile(fileName, firstDate, table);
+        }
+        else if (parser.isSet(urlOption))
+        {
+            loaded = downloadTable(&manager, parser.value(urlOption), instrumentId, table);
+        }
+        else
+        {
+            loaded = CurrencyChartStore::instance()->load(instrumentId, firstDate, table);
+        }
+        if ((!loaded) || (table.isEmpty()))
+        {
+            err << "No data for " << argument << "\n";
+            continue;
+        }
+
+        RenderJob job;
+        job.instrumentId = instrumentId;
+        job.outputFileName = outputDir.filePath(instrumentId + ".png");
+        job.renderer.setTable(table);
+        job.renderer.setRect(QRectF(0, 0, width, height));
+        job.renderer.update();
+        jobs << job;
+    }
+
+    // Одиночки создаются при первом обращении и без блокировки - создаём их до запуска потоков
+    Design::instance();
+    ChartLabelCache::instance();
+
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::blockingMap(jobs, renderJob);
+    double seconds = qMax(timer.nsecsElapsed() / 1e9, 1e-9);
+
+    int rendered = 0;
+    foreach (const RenderJob &job, jobs)
+    {
+        if (job.ok)
+        {
+            rendered++;
+        }
+        else
+        {
+            err << "Cannot write " << job.outputFileName << "\n";
+        }
+    }
+    out << QString("Rendered %1 of %2 charts in %3 s on %4 threads: %5 charts/s")
+           .arg(rendered)
+           .arg(parser.positionalArguments().count())
+           .arg(seconds, 0, 'f', 3)
+           .arg(QThreadPool::globalInstance()->maxThreadCount())
+           .arg(jobs.count() / seconds, 0, 'f', 1)
+        << "\n";
+    ChartLabelCache *cache = ChartLabelCache::instance();
+    out << QString("Label cache hit rate: widths %1%, texts %2%")
+           .arg(cache->widthHitRate() * 100, 0, 'f', 1)
+           .arg(cache->textHitRate() * 100, 0, 'f', 1)
+        << "\n";
+
+    return (rendered == parser.positionalArguments().count()) ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#-------------------------------------------------
+#
+# CurrencyChartStore: чтение файла серии против разбора ответа ЦБ РФ при открытии графика
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+TARGET = tst_currencychartstore
+TEMPLATE = app
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_currencychartstore.cpp \
+    ../../currencychartstore.cpp \
+    ../../currencycharttable.cpp \
+    ../../currencyinstrument.cpp \
+    ../../currencyreplyparser.cpp \
+    ../../floatroutine.cpp
+
+HEADERS  += ../../currencychartstore.h \
+    ../../currencycharttable.h \
+    ../../currencyinstrument.h \
+    ../../currencyreplyparser.h \
+    ../../floatroutine.h \
+    ../../indexsortheplert.h \
+    ../../singletont.h
+
+CONFIG += c++11
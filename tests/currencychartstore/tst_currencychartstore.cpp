@@ -0,0 +1,180 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "currencychartstore.h"
+#include "currencyreplyparser.h"
+
+// Тот же ответ XML_dynamic.asp, что и в tests/currencyreplyparser: доллар США за 2010-2019 годы
+static QByteArray readTestData(const QString &fileName)
+{
+    QFile file(QFINDTESTDATA("../data/" + fileName));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+// Открытие графика без хранилища: ответ сервера читается и разбирается так же,
+// как CurrencyChartCache разбирает ответ из сети
+static bool openReply(const QString &fileName, CurrencyChartTable &table)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    CurrencyChartReplyParser parser;
+    parser.addData(file.readAll());
+    bool result = parser.finish();
+    table = parser.table();
+    table.sortByDate();
+    return result;
+}
+
+static QByteArray littleEndian(qint32 value)
+{
+    QByteArray result(sizeof(value), '\0');
+    qToLittleEndian<qint32>(value, reinterpret_cast<uchar*>(result.data()));
+    return result;
+}
+
+static bool writeBytes(const QString &fileName, const QByteArray &data)
+{
+    QFile file(fileName);
+    return (file.open(QIODevice::WriteOnly)) && (file.write(data) == data.size());
+}
+
+//******************************************************************************************************
+/*!
+ *\class TestCurrencyChartStore
+*/
+//******************************************************************************************************
+
+class TestCurrencyChartStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void readFileMatchesReply();
+    void damagedFileIsRejected_data();
+    void damagedFileIsRejected();
+    void coldOpenBenchmark_data();
+    void coldOpenBenchmark();
+
+private:
+    QTemporaryDir m_directory;
+    QString m_replyFileName;
+    QString m_storeFileName;
+    QDate m_firstDate;
+    CurrencyChartTable m_table;
+};
+
+void TestCurrencyChartStore::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+    m_replyFileName = m_directory.path() + "/R01235.xml";
+    m_storeFileName = m_directory.path() + "/R01235.series";
+    m_firstDate = QDate(2010, 1, 1);
+
+    QByteArray reply = readTestData("XML_dynamic_R01235.xml");
+    QVERIFY(!reply.isEmpty());
+    QVERIFY(writeBytes(m_replyFileName, reply));
+    QVERIFY(openReply(m_replyFileName, m_table));
+    QCOMPARE(m_table.count(), 2544);
+    QVERIFY(CurrencyChartStore::writeFile(m_storeFileName, m_firstDate, m_table));
+}
+
+void TestCurrencyChartStore::readFileMatchesReply()
+{
+    QDate firstDate;
+    CurrencyChartTable table;
+    QVERIFY(CurrencyChartStore::readFile(m_storeFileName, firstDate, table));
+    QCOMPARE(firstDate, m_firstDate);
+    QCOMPARE(table.count(), m_table.count());
+    // Столбцы хранятся побитово
+    QVERIFY(table.julianDays() == m_table.julianDays());
+    QVERIFY(table.values() == m_table.values());
+    QVERIFY(table.nominals() == m_table.nominals());
+}
+
+void TestCurrencyChartStore::damagedFileIsRejected_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("offset");
+    QTest::addColumn<QByteArray>("patch");
+
+    // Смещения столбцов в файле m_storeFileName: даты с 32, значения с 32 + 4*2544
+    QTest::newRow("empty") << 0 << -1 << QByteArray();
+    QTest::newRow("header only") << 32 << -1 << QByteArray();
+    QTest::newRow("truncated columns") << 20000 << -1 << QByteArray();
+    QTest::newRow("signature") << -1 << 0 << QByteArray("X");
+    QTest::newRow("version") << -1 << 4 << QByteArray("\x02");
+    QTest::newRow("row count") << -1 << 9 << QByteArray("\x7f");
+    QTest::newRow("first date after first row") << -1 << 12 << littleEndian(m_table.julianDay(0) + 1);
+    QTest::newRow("date column inside header") << -1 << 16 << littleEndian(8);
+    QTest::newRow("misaligned value column") << -1 << 20 << littleEndian(32 + 4*2544 + 4);
+    QTest::newRow("repeated date") << -1 << 36 << littleEndian(m_table.julianDay(0));
+    QTest::newRow("decreasing date") << -1 << 36 << littleEndian(m_table.julianDay(0) - 1);
+}
+
+void TestCurrencyChartStore::damagedFileIsRejected()
+{
+    QFETCH(int, size);
+    QFETCH(int, offset);
+    QFETCH(QByteArray, patch);
+
+    QFile file(m_storeFileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray data = file.readAll();
+    if (size >= 0)
+    {
+        data.truncate(size);
+    }
+    if (offset >= 0)
+    {
+        data.replace(offset, patch.size(), patch);
+    }
+    QString fileName = m_directory.path() + "/damaged.series";
+    QVERIFY(writeBytes(fileName, data));
+
+    QDate firstDate;
+    CurrencyChartTable table;
+    QVERIFY(!CurrencyChartStore::readFile(fileName, firstDate, table));
+    QVERIFY(!firstDate.isValid());
+    QVERIFY(table.isEmpty());
+}
+
+void TestCurrencyChartStore::coldOpenBenchmark_data()
+{
+    QTest::addColumn<bool>("isStore");
+
+    QTest::newRow("CurrencyChartStore::readFile") << true;
+    QTest::newRow("CurrencyChartReplyParser") << false;
+}
+
+void TestCurrencyChartStore::coldOpenBenchmark()
+{
+    QFETCH(bool, isStore);
+
+    // Каждая итерация открывает файл заново, как при открытии графика; страницы файла
+    // при этом остаются в кэше ОС, так что время диска не учитывается
+    CurrencyChartTable table;
+    QBENCHMARK
+    {
+        if (isStore)
+        {
+            QDate firstDate;
+            CurrencyChartStore::readFile(m_storeFileName, firstDate, table);
+        }
+        else
+        {
+            openReply(m_replyFileName, table);
+        }
+    }
+    QCOMPARE(table.count(), m_table.count());
+}
+
+QTEST_APPLESS_MAIN(TestCurrencyChartStore)
+
+#include "tst_currencychartstore.moc"
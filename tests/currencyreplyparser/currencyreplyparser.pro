@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Разбор ответов ЦБ РФ: сравнение с QDomDocument и strtod(), скорость разбора
+#
+#-------------------------------------------------
+
+QT       += core xml testlib
+QT       -= gui
+
+TARGET = tst_currencyreplyparser
+TEMPLATE = app
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_currencyreplyparser.cpp \
+    ../../currencycharttable.cpp \
+    ../../currencyinstrument.cpp \
+    ../../currencyreplyparser.cpp \
+    ../../floatroutine.cpp
+
+HEADERS  += ../../currencycharttable.h \
+    ../../currencyinstrument.h \
+    ../../currencyreplyparser.h \
+    ../../floatroutine.h \
+    ../../indexsortheplert.h
+
+CONFIG += c++11
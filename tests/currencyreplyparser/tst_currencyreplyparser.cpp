@@ -0,0 +1,415 @@
+#include <QtTest>
+#include <QDomDocument>
+#include <stdlib.h>
+#include "currencyreplyparser.h"
+#include "floatroutine.h"
+
+// Ответы сервера ЦБ РФ в кодировке windows-1251, как они приходят из сети:
+// XML_dynamic.asp?VAL_NM_RQ=R01235 за 2010-2019 годы и XML_val.asp?d=0
+static QByteArray readTestData(const QString &fileName)
+{
+    QFile file(QFINDTESTDATA("../data/" + fileName));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+// Прежний разбор истории через QDomDocument (CurrencyChartCache::parseReply)
+static bool parseChartReplyWithDom(const QByteArray &replyData, CurrencyChartTable &table)
+{
+    table.clear();
+    QDomDocument document;
+    if (!document.setContent(replyData))
+    {
+        return false;
+    }
+    QDomElement de = document.documentElement();
+    for (QDomElement recordElement = de.firstChildElement("Record"); !recordElement.isNull(); recordElement = recordElement.nextSiblingElement("Record"))
+    {
+        QDate date = QDate::fromString(recordElement.attribute("Date"), "dd.MM.yyyy");
+        bool valueOk = false;
+        double value = recordElement.firstChildElement("Value").text().replace(",", ".").toDouble(&valueOk);
+        bool nominalOk = false;
+        double nominal = recordElement.firstChildElement("Nominal").text().replace(",", ".").toDouble(&nominalOk);
+        if ((date.isValid()) && (valueOk) && (nominalOk))
+        {
+            table << CurrencyChartRow(date, value, nominal);
+        }
+    }
+    table.sortByDate();
+    return true;
+}
+
+// Прежний разбор списка валют через QDomDocument (SearchEngine::onReplyFinished)
+static bool parseInstrumentReplyWithDom(const QByteArray &replyData, QList<CurrencyInstrument> &instruments)
+{
+    instruments.clear();
+    QDomDocument doc;
+    if (!doc.setContent(replyData))
+    {
+        return false;
+    }
+    QDomElement root = doc.documentElement();
+    for (QDomElement itemElement = root.firstChildElement("Item"); !itemElement.isNull(); itemElement = itemElement.nextSiblingElement("Item"))
+    {
+        QString id = itemElement.attribute("ID");
+        QString name = itemElement.firstChildElement("Name").text();
+        if ((!id.isEmpty()) && (!name.isEmpty()))
+        {
+            instruments << CurrencyInstrument(id, name);
+        }
+    }
+    return true;
+}
+
+// Ответ подаётся в разборщик частями по chunkSize байт, как из readyRead()
+static bool parseChartReply(const QByteArray &replyData, int chunkSize, CurrencyChartTable &table)
+{
+    CurrencyChartReplyParser parser;
+    for (int i = 0; i < replyData.size(); i += chunkSize)
+    {
+        parser.addData(replyData.mid(i, chunkSize));
+    }
+    bool result = parser.finish();
+    table = parser.table();
+    table.sortByDate();
+    return result;
+}
+
+static bool parseInstrumentReply(const QByteArray &replyData, int chunkSize, QList<CurrencyInstrument> &instruments)
+{
+    CurrencyInstrumentReplyParser parser;
+    for (int i = 0; i < replyData.size(); i += chunkSize)
+    {
+        parser.addData(replyData.mid(i, chunkSize));
+    }
+    bool result = parser.finish();
+    instruments = parser.instruments();
+    return result;
+}
+
+// Эталон для parseDecimal(): strtod() в локали "C"
+static bool strtodDecimal(const QString &text, double &value)
+{
+    QByteArray latin = text.trimmed().toLatin1().replace(',', '.');
+    if (latin.isEmpty())
+    {
+        return false;
+    }
+    char *end = NULL;
+    value = strtod(latin.constData(), &end);
+    return (end == latin.constData() + latin.size());
+}
+
+//******************************************************************************************************
+/*!
+ *\class DecimalRandom
+ *\brief Воспроизводимый генератор чисел в записи ЦБ РФ (xorshift32).
+*/
+//******************************************************************************************************
+
+class DecimalRandom
+{
+public:
+    explicit DecimalRandom(quint32 seed)
+        :m_state(seed ? seed : 1)
+    {
+    }
+
+    int bounded(int count)
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return int(m_state % quint32(count));
+    }
+
+    // Целая часть до 12 цифр, дробная - до 10, запятая или точка; изредка знак и пробелы по краям
+    QString decimal()
+    {
+        QString result;
+        if (bounded(32) == 0)
+        {
+            result += (bounded(2) == 0) ? QChar('-') : QChar('+');
+        }
+        int integerDigits = 1 + bounded(12);
+        for (int i = 0; i < integerDigits; i++)
+        {
+            result += QChar('0' + ((i == 0) && (integerDigits > 1) ? 1 + bounded(9) : bounded(10)));
+        }
+        int fractionDigits = bounded(11);
+        if (fractionDigits > 0)
+        {
+            result += (bounded(8) == 0) ? QChar('.') : QChar(',');
+            for (int i = 0; i < fractionDigits; i++)
+            {
+                result += QChar('0' + bounded(10));
+            }
+        }
+        if (bounded(64) == 0)
+        {
+            result = QString(" ") + result + QString("  ");
+        }
+        return result;
+    }
+
+private:
+    quint32 m_state;
+};
+
+//******************************************************************************************************
+/*!
+ *\class TestCurrencyReplyParser
+*/
+//******************************************************************************************************
+
+class TestCurrencyReplyParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void chartReplyMatchesDom_data();
+    void chartReplyMatchesDom();
+    void instrumentReplyMatchesDom_data();
+    void instrumentReplyMatchesDom();
+    void truncatedReplyIsRejected();
+    void parseDecimal_data();
+    void parseDecimal();
+    void parseDecimalMatchesStrtod();
+    void parseDate_data();
+    void parseDate();
+    void chartReplyBenchmark_data();
+    void chartReplyBenchmark();
+    void instrumentReplyBenchmark_data();
+    void instrumentReplyBenchmark();
+
+private:
+    QByteArray m_chartReply;
+    QByteArray m_instrumentReply;
+};
+
+void TestCurrencyReplyParser::initTestCase()
+{
+    m_chartReply = readTestData("XML_dynamic_R01235.xml");
+    m_instrumentReply = readTestData("XML_val.xml");
+    QVERIFY(!m_chartReply.isEmpty());
+    QVERIFY(!m_instrumentReply.isEmpty());
+}
+
+void TestCurrencyReplyParser::chartReplyMatchesDom_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("whole reply") << m_chartReply.size();
+    QTest::newRow("16 KiB chunks") << 16384;
+    QTest::newRow("1500 byte chunks") << 1500;
+    QTest::newRow("7 byte chunks") << 7;
+    QTest::newRow("1 byte chunks") << 1;
+}
+
+void TestCurrencyReplyParser::chartReplyMatchesDom()
+{
+    QFETCH(int, chunkSize);
+
+    CurrencyChartTable expected;
+    QVERIFY(parseChartReplyWithDom(m_chartReply, expected));
+    QCOMPARE(expected.count(), 2544);
+
+    CurrencyChartTable actual;
+    QVERIFY(parseChartReply(m_chartReply, chunkSize, actual));
+    QCOMPARE(actual.count(), expected.count());
+    for (int i = 0; i < expected.count(); i++)
+    {
+        // Значения должны совпадать побитово, а не с точностью qFuzzyCompare()
+        QVERIFY2((actual.julianDay(i) == expected.julianDay(i)) && (actual.value(i) == expected.value(i)) && (actual.nominal(i) == expected.nominal(i)),
+                 (QString("row %1: expected %2, actual %3").arg(i).arg(expected[i].toString()).arg(actual[i].toString())).toUtf8().constData());
+    }
+}
+
+void TestCurrencyReplyParser::instrumentReplyMatchesDom_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("whole reply") << m_instrumentReply.size();
+    QTest::newRow("1500 byte chunks") << 1500;
+    QTest::newRow("1 byte chunks") << 1;
+}
+
+void TestCurrencyReplyParser::instrumentReplyMatchesDom()
+{
+    QFETCH(int, chunkSize);
+
+    QList<CurrencyInstrument> expected;
+    QVERIFY(parseInstrumentReplyWithDom(m_instrumentReply, expected));
+    QCOMPARE(expected.count(), 69);
+    QCOMPARE(expected[17].name, QString::fromUtf8("Доллар США"));
+
+    QList<CurrencyInstrument> actual;
+    QVERIFY(parseInstrumentReply(m_instrumentReply, chunkSize, actual));
+    QCOMPARE(actual.count(), expected.count());
+    for (int i = 0; i < expected.count(); i++)
+    {
+        QCOMPARE(actual[i].id, expected[i].id);
+        QCOMPARE(actual[i].name, expected[i].name);
+    }
+}
+
+void TestCurrencyReplyParser::truncatedReplyIsRejected()
+{
+    // Оборванный ответ отвергается целиком, как его отвергал QDomDocument::setContent()
+    QByteArray truncated = m_chartReply.left(m_chartReply.size() / 2);
+    CurrencyChartTable table;
+    QVERIFY(!parseChartReplyWithDom(truncated, table));
+    QVERIFY(!parseChartReply(truncated, 4096, table));
+
+    QList<CurrencyInstrument> instruments;
+    QVERIFY(!parseInstrumentReply(m_instrumentReply.left(m_instrumentReply.size() - 3), 4096, instruments));
+}
+
+void TestCurrencyReplyParser::parseDecimal_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("rate") << QString("72,9299");
+    QTest::newRow("nominal") << QString("1");
+    QTest::newRow("large nominal") << QString("100000");
+    QTest::newRow("small fraction") << QString("0,0001");
+    QTest::newRow("point") << QString("30.1851");
+    QTest::newRow("negative") << QString("-1,5");
+    QTest::newRow("plus") << QString("+2,25");
+    QTest::newRow("spaces") << QString(" 12,3  ");
+    QTest::newRow("2^53") << QString("9007199254740992");
+    QTest::newRow("above 2^53") << QString("9007199254740993");
+    QTest::newRow("22 fraction digits") << QString("0,0000000000000000000001");
+    QTest::newRow("long fraction") << QString("0,1234567890123456789012");
+    QTest::newRow("23 fraction digits") << QString("0,12345678901234567890123");
+    QTest::newRow("long mantissa") << QString("123456789012345678901,5");
+    QTest::newRow("exponent") << QString("1,5e3");
+    QTest::newRow("empty") << QString("");
+    QTest::newRow("spaces only") << QString("   ");
+    QTest::newRow("sign only") << QString("-");
+    QTest::newRow("two separators") << QString("1,2,3");
+    QTest::newRow("letters") << QString("n/a");
+}
+
+void TestCurrencyReplyParser::parseDecimal()
+{
+    QFETCH(QString, text);
+
+    // Результат должен совпадать с прежней заменой запятой и QString::toDouble()
+    bool expectedOk = false;
+    double expected = QString(text).replace(",", ".").toDouble(&expectedOk);
+    double actual = 0;
+    bool actualOk = CurrencyReplyParser::parseDecimal(QStringRef(&text), actual);
+    QCOMPARE(actualOk, expectedOk);
+    if (expectedOk)
+    {
+        QVERIFY2(actual == expected, (QByteArray::number(actual, 'g', 17) + " != " + QByteArray::number(expected, 'g', 17)).constData());
+    }
+    else
+    {
+        QVERIFY(isNaN(actual));
+    }
+}
+
+void TestCurrencyReplyParser::parseDecimalMatchesStrtod()
+{
+    // Два миллиона случайных чисел в записи ЦБ РФ: быстрый путь обязан давать тот же double, что strtod()
+    static const int DecimalCount = 2000000;
+    DecimalRandom random(20100101);
+    for (int i = 0; i < DecimalCount; i++)
+    {
+        QString text = random.decimal();
+        double expected = 0;
+        QVERIFY(strtodDecimal(text, expected));
+        double actual = 0;
+        bool ok = CurrencyReplyParser::parseDecimal(QStringRef(&text), actual);
+        QVERIFY2((ok) && (actual == expected),
+                 (text + ": " + QString::number(actual, 'g', 17) + " != " + QString::number(expected, 'g', 17)).toUtf8().constData());
+    }
+}
+
+void TestCurrencyReplyParser::parseDate_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("regular") << QString("12.01.2010");
+    QTest::newRow("leap day") << QString("29.02.2012");
+    QTest::newRow("not a leap day") << QString("29.02.2011");
+    QTest::newRow("month 13") << QString("01.13.2010");
+    QTest::newRow("single digit day") << QString("1.02.2010");
+    QTest::newRow("letters") << QString("aa.bb.cccc");
+    QTest::newRow("empty") << QString("");
+}
+
+void TestCurrencyReplyParser::parseDate()
+{
+    QFETCH(QString, text);
+
+    QCOMPARE(CurrencyReplyParser::parseDate(QStringRef(&text)), QDate::fromString(text, "dd.MM.yyyy"));
+}
+
+void TestCurrencyReplyParser::chartReplyBenchmark_data()
+{
+    QTest::addColumn<bool>("isDom");
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("QDomDocument") << true << 0;
+    QTest::newRow("stream, whole reply") << false << m_chartReply.size();
+    QTest::newRow("stream, 16 KiB chunks") << false << 16384;
+}
+
+void TestCurrencyReplyParser::chartReplyBenchmark()
+{
+    QFETCH(bool, isDom);
+    QFETCH(int, chunkSize);
+
+    // Десять лет истории, около 300 КБ
+    CurrencyChartTable table;
+    QBENCHMARK
+    {
+        if (isDom)
+        {
+            parseChartReplyWithDom(m_chartReply, table);
+        }
+        else
+        {
+            parseChartReply(m_chartReply, chunkSize, table);
+        }
+    }
+    QCOMPARE(table.count(), 2544);
+}
+
+void TestCurrencyReplyParser::instrumentReplyBenchmark_data()
+{
+    QTest::addColumn<bool>("isDom");
+
+    QTest::newRow("QDomDocument") << true;
+    QTest::newRow("stream") << false;
+}
+
+void TestCurrencyReplyParser::instrumentReplyBenchmark()
+{
+    QFETCH(bool, isDom);
+
+    QList<CurrencyInstrument> instruments;
+    QBENCHMARK
+    {
+        if (isDom)
+        {
+            parseInstrumentReplyWithDom(m_instrumentReply, instruments);
+        }
+        else
+        {
+            parseInstrumentReply(m_instrumentReply, m_instrumentReply.size(), instruments);
+        }
+    }
+    QCOMPARE(instruments.count(), 69);
+}
+
+QTEST_APPLESS_MAIN(TestCurrencyReplyParser)
+
+#include "tst_currencyreplyparser.moc"
@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Подбор шага FloatScale в замкнутой форме против прежнего перебора
+#
+#-------------------------------------------------
+
+QT       += core gui testlib
+
+TARGET = tst_floatscale
+TEMPLATE = app
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_floatscale.cpp \
+    loopfloatscale.cpp \
+    ../../chartlabelcache.cpp \
+    ../../chartroutine.cpp \
+    ../../floatroutine.cpp \
+    ../../numeral.cpp
+
+HEADERS  += loopfloatscale.h \
+    ../../chartlabelcache.h \
+    ../../chartroutine.h \
+    ../../floatroutine.h \
+    ../../numeral.h \
+    ../../singletont.h
+
+CONFIG += c++11
@@ -0,0 +1,137 @@
+#include "loopfloatscale.h"
+#include <float.h>
+#include <math.h>
+#include "floatroutine.h"
+
+static const int criticalMarkCount = 200;
+
+//******************************************************************************************************
+/*!
+ *\class LoopFloatScale
+*/
+//******************************************************************************************************
+
+LoopFloatScale::LoopFloatScale()
+    : Scale()
+    , m_step(0)
+    , m_stepPrecision(0)
+    , m_stepNumeralFormat()
+    , m_markList()
+{
+
+}
+
+FloatScaleMarkList LoopFloatScale::markList() const
+{
+    return m_markList;
+}
+
+void LoopFloatScale::computeParams()
+{
+    computeStep();
+    computeMarkList();
+}
+
+int LoopFloatScale::stepPrecision(double step, int tuneDigits) const
+{
+    return tuneDigits - floor(log(step) / log(10.0));
+}
+
+FloatRange LoopFloatScale::stepRange(double step) const
+{
+    FloatRange result;
+    result << step * ceil(screenToLogic(screenPoints().minMarkPoint) / step);
+    result << step * floor(screenToLogic(screenPoints().maxMarkPoint) / step);
+    return result;
+}
+
+bool LoopFloatScale::isStepAvailable(double step, int tuneDigits) const
+{
+    Numeral numeral(NumeralFormat(false, true, stepPrecision(step, tuneDigits), false, false));
+    FloatRange range = stepRange(step);
+    double distanceBetween = step * abs(worstScaleCoef());
+    return
+            isStepStringAvailable(numeral.toString(range.min), distanceBetween) &&
+            isStepStringAvailable(numeral.toString(range.max), distanceBetween);
+}
+
+void LoopFloatScale::findStep(double min, double max)
+{
+    m_step = 0;
+    if (max-min > FLT_EPSILON)
+    {
+        int p = ceil(log(max-min) / log(10.0));
+        double delta = pow(10.0, p);
+        int tuneDigits = 0;
+        double nextDelta = pow(10.0, p-1);
+        double prevDelta = delta;
+        int prevTuneDigits = tuneDigits;
+        while (isStepAvailable(delta, tuneDigits) && (delta > FLT_EPSILON))
+        {
+            prevDelta = delta;
+            prevTuneDigits = tuneDigits;
+            if (delta > nextDelta * 5.5)
+            {
+                delta = nextDelta * 5;
+                tuneDigits = 0;
+            }
+            else if (delta > nextDelta * 2.6)
+            {
+                delta = nextDelta * 2.5;
+                tuneDigits = 1;
+            }
+            else if (delta > nextDelta * 2.02)
+            {
+                delta = nextDelta * 2;
+                tuneDigits = 0;
+            }
+            else
+            {
+                p = p - 1;
+                delta = pow(10.0, p);
+                tuneDigits = 0;
+                nextDelta = pow(10.0, p-1);
+            }
+        }
+        m_step = prevDelta;
+        m_stepPrecision = stepPrecision(prevDelta, prevTuneDigits);
+    }
+}
+
+void LoopFloatScale::computeStep()
+{
+    if (!logicRange().isValid())
+    {
+        m_step = 0;
+        m_stepNumeralFormat.clear();
+    }
+    else if (!logicRange().isSingleValue())
+    {
+        findStep(logicRange().min, logicRange().max);
+        m_stepNumeralFormat = NumeralFormat(false, true, m_stepPrecision, false, false);
+    }
+}
+
+void LoopFloatScale::computeMarkList()
+{
+    m_markList.clear();
+    if (!isReady())
+    {
+        return;
+    }
+    if ((logicRange().isSingleValue()) || (m_step <= FLT_EPSILON*2.0))
+    {
+        // Единственная метка на шкале
+        double value = logicRange().singleValue();
+        m_markList << FloatScaleMark(value, Numeral::format(value), logicToScreen(value));
+    }
+    else
+    {
+        // Диапазон значений на шкале
+        FloatRange range = stepRange(m_step);
+        for (double value = range.min; ((value <= range.max) && (m_markList.count() < criticalMarkCount)); value += m_step)
+        {
+            m_markList << FloatScaleMark(value, Numeral::format(value, m_stepNumeralFormat), logicToScreen(value));
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef LOOPFLOATSCALE_H
+#define LOOPFLOATSCALE_H
+
+#include "chartroutine.h"
+
+// Прежняя реализация FloatScale: шаг подбирается перебором ряда 10^p, 5, 2.5, 2, 1 * 10^(p-1), ...
+// с форматированием подписей на каждом шаге. Оставлена только как эталон для проверки.
+class LoopFloatScale : public Scale
+{
+public:
+    LoopFloatScale();
+    FloatScaleMarkList markList() const;
+
+protected:
+    void computeParams() override;
+
+private:
+    double m_step;
+    int m_stepPrecision;
+    NumeralFormat m_stepNumeralFormat;
+    FloatScaleMarkList m_markList;
+    int stepPrecision(double step, int tuneDigits) const;
+    FloatRange stepRange(double step) const;
+    bool isStepAvailable(double step, int tuneDigits) const;
+    void findStep(double min, double max);
+    void computeStep();
+    void computeMarkList();
+};
+
+#endif // LOOPFLOATSCALE_H
@@ -0,0 +1,227 @@
+#include <QtTest>
+#include <QGuiApplication>
+#include <math.h>
+#include "chartroutine.h"
+#include "floatroutine.h"
+#include "loopfloatscale.h"
+
+//******************************************************************************************************
+/*!
+ *\class ScaleRandom
+ *\brief Воспроизводимый генератор случайных параметров шкалы (xorshift32).
+*/
+//******************************************************************************************************
+
+class ScaleRandom
+{
+public:
+    explicit ScaleRandom(quint32 seed)
+        :m_state(seed ? seed : 1)
+    {
+    }
+
+    int bounded(int count)
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return int(m_state % quint32(count));
+    }
+
+    // Случайное число 1.000 ... 9.999, умноженное на 10^exponent
+    double decimal(int exponent)
+    {
+        return (1000 + bounded(9000)) / 1000.0 * pow(10.0, exponent);
+    }
+
+    // Диапазон значений графика: от курсов около единицы до индексов в тысячи, шириной
+    // от долей процента до нескольких порядков; изредка - почти вырожденный
+    FloatRange range()
+    {
+        double min = (bounded(8) == 0) ? 0 : decimal(bounded(12) - 5);
+        double length = 0;
+        switch (bounded(8))
+        {
+        case 0:
+            length = decimal(-9 + bounded(4));
+            break;
+        case 1:
+            length = decimal(bounded(12) - 5);
+            break;
+        default:
+            length = (min > 0) ? min * decimal(-4 + bounded(5)) : decimal(bounded(6) - 2);
+            break;
+        }
+        return FloatRange(min, min + length);
+    }
+
+private:
+    quint32 m_state;
+};
+
+static bool isSame(double value1, double value2)
+{
+    return (value1 == value2) || ((isNaN(value1)) && (isNaN(value2)));
+}
+
+static QByteArray describe(const FloatScaleMarkList &list)
+{
+    QStringList result;
+    foreach (const FloatScaleMark &mark, list)
+    {
+        result << QString("%1 \"%2\" at %3").arg(mark.value, 0, 'g', 17).arg(mark.text).arg(mark.position, 0, 'g', 17);
+    }
+    return result.join(", ").toUtf8();
+}
+
+// Шкала настраивается так же, как вертикальная шкала CurrencyChartRenderer
+template <class ScaleClass>
+static void setUpScale(ScaleClass &scale, Qt::Orientation orientation, const QFont &font, double spacing, bool exponential)
+{
+    scale.setOrientation(orientation);
+    scale.setFont(font);
+    scale.setMinimalMarkSpacing(spacing);
+    scale.setRequestUseExponentialTransformation(exponential);
+}
+
+static ScreenPoints screenPointsForHeight(int height)
+{
+    return ScreenPoints(height - 24 - 6, 6);
+}
+
+//******************************************************************************************************
+/*!
+ *\class TestFloatScale
+*/
+//******************************************************************************************************
+
+class TestFloatScale : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesStepLoop_data();
+    void matchesStepLoop();
+    void resizeBenchmark_data();
+    void resizeBenchmark();
+};
+
+void TestFloatScale::matchesStepLoop_data()
+{
+    QTest::addColumn<int>("orientation");
+    QTest::addColumn<bool>("exponential");
+    QTest::addColumn<int>("scaleCount");
+
+    // Подбор шага в замкнутой форме работает только для вертикальной шкалы;
+    // горизонтальная проверяется, чтобы убедиться, что перебор для неё не изменился
+    QTest::newRow("vertical, linear") << int(Qt::Vertical) << false << 100000;
+    QTest::newRow("vertical, exponential") << int(Qt::Vertical) << true << 50000;
+    QTest::newRow("horizontal, linear") << int(Qt::Horizontal) << false << 20000;
+}
+
+void TestFloatScale::matchesStepLoop()
+{
+    QFETCH(int, orientation);
+    QFETCH(bool, exponential);
+    QFETCH(int, scaleCount);
+
+    ScaleRandom random(quint32(orientation*10 + (exponential ? 1 : 0)));
+    for (int i = 0; i < scaleCount; i++)
+    {
+        QFont font;
+        font.setPixelSize(8 + random.bounded(17));
+        double spacing = random.bounded(41) / 2.0;
+        FloatRange range = random.range();
+        ScreenPoints screenPoints = screenPointsForHeight(60 + random.bounded(2000));
+
+        FloatScale scale;
+        setUpScale(scale, Qt::Orientation(orientation), font, spacing, exponential);
+        scale.setScreenPoints(screenPoints);
+        scale.setLogicRange(range);
+
+        LoopFloatScale reference;
+        setUpScale(reference, Qt::Orientation(orientation), font, spacing, exponential);
+        reference.setScreenPoints(screenPoints);
+        reference.setLogicRange(range);
+
+        FloatScaleMarkList actual = scale.markList();
+        FloatScaleMarkList expected = reference.markList();
+        QByteArray message =
+                QByteArray("scale ") + QByteArray::number(i) +
+                ": range " + range.toString().toUtf8() +
+                ", font " + QByteArray::number(font.pixelSize()) +
+                "px, spacing " + QByteArray::number(spacing) +
+                ", screen " + QByteArray::number(screenPoints.pointAtMin) + "-" + QByteArray::number(screenPoints.pointAtMax) +
+                "\nexpected: " + describe(expected) +
+                "\nactual:   " + describe(actual);
+        QVERIFY2(actual.count() == expected.count(), message.constData());
+        for (int j = 0; j < actual.count(); j++)
+        {
+            QVERIFY2(isSame(actual[j].value, expected[j].value), message.constData());
+            QVERIFY2(actual[j].text == expected[j].text, message.constData());
+            QVERIFY2(isSame(actual[j].position, expected[j].position), message.constData());
+        }
+    }
+}
+
+void TestFloatScale::resizeBenchmark_data()
+{
+    QTest::addColumn<bool>("isLoop");
+
+    QTest::newRow("FloatScale") << false;
+    QTest::newRow("LoopFloatScale") << true;
+}
+
+void TestFloatScale::resizeBenchmark()
+{
+    QFETCH(bool, isLoop);
+
+    // Изменение высоты графика от 200 до 800 точек и обратно по одной точке:
+    // шкала пересчитывается при каждом изменении, как при перетаскивании края окна
+    QList<ScreenPoints> steps;
+    for (int height = 200; height < 800; height++)
+    {
+        steps << screenPointsForHeight(height);
+    }
+    for (int height = 800; height > 200; height--)
+    {
+        steps << screenPointsForHeight(height);
+    }
+
+    QFont font;
+    font.setPixelSize(11);
+    FloatScale scale;
+    LoopFloatScale reference;
+    setUpScale(scale, Qt::Vertical, font, 10, false);
+    setUpScale(reference, Qt::Vertical, font, 10, false);
+    scale.setLogicRange(FloatRange(30.5, 82.3));
+    reference.setLogicRange(FloatRange(30.5, 82.3));
+    QBENCHMARK
+    {
+        foreach (const ScreenPoints &screenPoints, steps)
+        {
+            if (isLoop)
+            {
+                reference.setScreenPoints(screenPoints);
+            }
+            else
+            {
+                scale.setScreenPoints(screenPoints);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Окна не нужны: если платформа не задана явно, используется offscreen, как в TadraRender
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    TestFloatScale test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_floatscale.moc"
@@ -0,0 +1,438 @@
+#include "enumeratinggridcoordinategenerator.h"
+#include <math.h>
+#include "floatroutine.h"
+#include "indexsortheplert.h"
+
+//******************************************************************************************************
+/*!
+ *\class EnumeratingGridCoordinateGenerator
+*/
+//******************************************************************************************************
+
+EnumeratingGridCoordinateGenerator::EnumeratingGridCoordinateGenerator()
+    :m_minimalSegmentGridLength(1)
+    ,m_stackSegmentList()
+    ,m_supposedGridSpace()
+    ,m_gridSpace()
+    ,m_gridSegmentList()
+    ,m_vertexIndexes()
+    ,m_stackCoordinates()
+    ,m_adjacencyMatrix()
+    ,m_paths()
+    ,m_maxPathLength(0)
+    ,m_longestPath()
+    ,m_gridCoordinates()
+{
+}
+
+void EnumeratingGridCoordinateGenerator::setMinimalSegmentGridLength(int value)
+{
+    int correctedValue = qMax(value, 1);
+    if (m_minimalSegmentGridLength != correctedValue)
+    {
+        m_minimalSegmentGridLength = correctedValue;
+        computeAll();
+    }
+}
+
+int EnumeratingGridCoordinateGenerator::minimalSegmentGridLength() const
+{
+    return m_minimalSegmentGridLength;
+}
+
+void EnumeratingGridCoordinateGenerator::setStackSegmentList(const StackSegmentList &value)
+{
+    if (m_stackSegmentList != value)
+    {
+        m_stackSegmentList = value;
+        computeAll();
+    }
+}
+
+StackSegmentList EnumeratingGridCoordinateGenerator::stackSegmentList() const
+{
+    return m_stackSegmentList;
+}
+
+int EnumeratingGridCoordinateGenerator::minimalGridSpaceLength() const
+{
+    return m_maxPathLength * m_minimalSegmentGridLength;
+}
+
+void EnumeratingGridCoordinateGenerator::setSupposedGridSpace(const GridSegment &value)
+{
+    if (m_supposedGridSpace != value)
+    {
+        m_supposedGridSpace = value;
+        computeGridSpace();
+        computeGridCoordinates();
+        computeGridSegmentList();
+    }
+}
+
+GridSegment EnumeratingGridCoordinateGenerator::supposedGridSpace() const
+{
+    return m_supposedGridSpace;
+}
+
+GridSegment EnumeratingGridCoordinateGenerator::gridSpace() const
+{
+    return m_gridSpace;
+}
+
+GridSegmentList EnumeratingGridCoordinateGenerator::gridSegmentList() const
+{
+    return m_gridSegmentList;
+}
+
+class EnumeratingCoordinateIndexSortHelper : public IndexSortHelperT<double>
+{
+public:
+    bool isO1LessThanO2(const double &o1, const double &o2) const override
+    {
+        return o1 < o2;
+    }
+};
+
+void EnumeratingGridCoordinateGenerator::buildVertexes()
+{
+    DoubleVector stackCoordinates;
+    for (int i = 0; i < m_stackSegmentList.count(); i++)
+    {
+        stackCoordinates << m_stackSegmentList[i].min;
+        stackCoordinates << m_stackSegmentList[i].max;
+    }
+
+    EnumeratingCoordinateIndexSortHelper sorter;
+    sorter.setBaseVector(stackCoordinates);
+    qSort(sorter.indexes().begin(), sorter.indexes().end(), sorter);
+
+    m_stackCoordinates.clear();
+    m_vertexIndexes.clear();
+    reduceStackCoordinates(stackCoordinates, sorter.indexes(), m_stackCoordinates, m_vertexIndexes);
+}
+
+void EnumeratingGridCoordinateGenerator::buildAdjacencyMatrix()
+{
+    // Начальное заполнение
+    m_adjacencyMatrix.clear();
+    for (int i = 0; i < m_stackCoordinates.count(); i++)
+    {
+        IntVector row;
+        row.fill(-1, m_stackCoordinates.count());    // -1 нет связи между вершинами
+        if (i > 0)
+        {
+            row[i-1] = 0;   // 0 вершины связаны между собой, но не ограничены по дистанции
+        }
+        if (i < m_stackCoordinates.count()-1)
+        {
+            row[i+1] = 0;
+        }
+        m_adjacencyMatrix << row;
+    }
+
+    // Заполнение ограничениями по дистанции
+    for (int i = 0; i < m_stackSegmentList.count(); i++)
+    {
+        int vertex1 = m_vertexIndexes[i*2];
+        int vertex2 = m_vertexIndexes[i*2 + 1];
+        m_adjacencyMatrix[vertex1][vertex2] = 1;    // 1 вершины имеют ограничение по дистанции
+        m_adjacencyMatrix[vertex2][vertex1] = 1;
+    }
+}
+
+void EnumeratingGridCoordinateGenerator::computeGraph()
+{
+    buildVertexes();
+    buildAdjacencyMatrix();
+}
+
+IntVectorList EnumeratingGridCoordinateGenerator::pathsFrom(int vertex) const
+{
+    IntVectorList result;
+
+    // Путь, состоящий из текущей вершины
+    IntVector currentVertex;
+    currentVertex << vertex;
+
+    // Ищем низлежащие пути
+    for (int i = vertex + 1; i < m_stackCoordinates.count(); i++)
+    {
+        if (m_adjacencyMatrix[vertex][i] >= 0)
+        {
+            IntVectorList flowingSubpaths = pathsFrom(i);
+            foreach (const IntVector &flowingSubpath, flowingSubpaths)
+            {
+                IntVector path;
+                path << currentVertex;
+                path << flowingSubpath;
+                result << path;
+            }
+        }
+    }
+
+    if (result.isEmpty())
+    {
+        // Низлежащих путей нет
+        result << currentVertex;
+    }
+    return result;
+}
+
+int EnumeratingGridCoordinateGenerator::pathLength(const IntVector &path) const
+{
+    int sum = 0;
+    for (int i = 0; i < path.count()-1; i++)
+    {
+        int vertex1 = path[i];
+        int vertex2 = path[i+1];
+        int w = m_adjacencyMatrix[vertex1][vertex2];
+        if (w < 0)
+        {
+            // Некорректный путь
+            return -1;
+        }
+        else
+        {
+            sum += w;
+        }
+    }
+    return sum;
+}
+
+void EnumeratingGridCoordinateGenerator::computePaths()
+{
+    m_paths.clear();
+    if (m_stackCoordinates.count() >= 2)
+    {
+        m_paths = pathsFrom(0);
+    }
+}
+
+void EnumeratingGridCoordinateGenerator::computeLongestPath()
+{
+    m_longestPath = IntVector();
+    m_maxPathLength = 0;
+    foreach (const IntVector &path, m_paths)
+    {
+        int length = pathLength(path);
+        if (m_maxPathLength < length)
+        {
+            m_maxPathLength = length;
+            m_longestPath = path;
+        }
+    }
+}
+
+void EnumeratingGridCoordinateGenerator::computeGridSpace()
+{
+    // Вычисляем и устанавливаем используемый для фактического расчёта координат grid space
+    GridSegment gridSpace = m_supposedGridSpace;
+    int minLen = minimalGridSpaceLength();
+    if (!gridSpace.isValid())
+    {
+        gridSpace.min = 0;
+        gridSpace.max = minLen;
+    }
+    else if (gridSpace.length() < minLen)
+    {
+        gridSpace.max = gridSpace.min + minLen;
+    }
+    if (m_gridSpace != gridSpace)
+    {
+        m_gridSpace = gridSpace;
+    }
+}
+
+IntVector EnumeratingGridCoordinateGenerator::gridCoordinatesForPath(const GridSegment &gridSpace, const IntVector &path) const
+{
+    IntVector result;
+
+    // Начальная инициализация результата
+    result.fill(-1, path.count());
+    result[0] = gridSpace.min;
+
+    // Заполняем результат минимальными grid-координатами (соответственно, только для промежуточных вершин)
+    int currentGridCoordinate = gridSpace.min;
+    for (int i = 1; i < path.count(); i++)
+    {
+        int edgeLength = 0;
+        int vertex1 = path[i-1];
+        int vertex2 = path[i];
+        if (m_adjacencyMatrix[vertex1][vertex2] >= 1)
+        {
+            edgeLength = m_minimalSegmentGridLength;
+        }
+        currentGridCoordinate += edgeLength;
+        result[i] = currentGridCoordinate;
+    }
+
+    // Заполняем свободное пространство в соответствии со stack-координатами
+    double stackMin = m_stackCoordinates[path.first()];
+    double stackMax = m_stackCoordinates[path.last()];
+    int minGridSpace = pathLength(path)*m_minimalSegmentGridLength;
+    int remainGridSpace = gridSpace.length() - minGridSpace;
+    double remainStackSpace = (stackMax - stackMin)*(1 - double(minGridSpace)/double(gridSpace.length()));
+    if ((remainGridSpace) && (doubleGreater(remainStackSpace, 0)))
+    {
+        double segmentMinStackLength = double(m_minimalSegmentGridLength)/double(gridSpace.length())*(stackMax - stackMin);
+        double remainK = double(remainGridSpace) / remainStackSpace;
+        for (int i = 1; i < path.count(); i++)
+        {
+            int vertex1 = path[i-1];
+            int vertex2 = path[i];
+            double edgeRemainStackLength = m_stackCoordinates[vertex2] - m_stackCoordinates[vertex1];
+            if (m_adjacencyMatrix[vertex1][vertex2] >= 1)
+            {
+                edgeRemainStackLength -= segmentMinStackLength;
+            }
+            if (doubleGreater(edgeRemainStackLength, 0))
+            {
+                int edgeRemainGridLength = iround(edgeRemainStackLength * remainK);
+                edgeRemainGridLength = qMin(edgeRemainGridLength, gridSpace.max - result.last());
+                for (int j = i; j < path.count(); j++)
+                {
+                    result[j] += edgeRemainGridLength;
+                }
+            }
+        }
+    }
+
+    // Окончание вычисления
+    result[path.count()-1] = gridSpace.max;
+
+    return result;
+}
+
+void EnumeratingGridCoordinateGenerator::setGridCoordinatesForPath(const GridSegment &gridSpace, const IntVector &path)
+{
+    IntVector gpc = gridCoordinatesForPath(gridSpace, path);
+    for (int i = 0; i < path.count(); i++)
+    {
+        int vertex = path[i];
+        m_gridCoordinates[vertex] = gpc[i];
+    }
+}
+
+IntVector EnumeratingGridCoordinateGenerator::findBearingPath1(int vertex, const IntVector &path) const
+{
+    IntVector result;
+    int vertexIndex = path.indexOf(vertex);
+    if (vertexIndex >= 0)
+    {
+        int startFrom = vertexIndex;
+        for (int i = vertexIndex-1; i >= 0; i--)
+        {
+            startFrom = i;
+            if (m_gridCoordinates[path[i]] >= 0)
+            {
+                break;
+            }
+        }
+        int endTo = vertexIndex;
+        for (int i = vertexIndex+1; i < path.count(); i++)
+        {
+            endTo = i;
+            if (m_gridCoordinates[path[i]] >= 0)
+            {
+                break;
+            }
+        }
+        result = path.mid(startFrom, endTo - startFrom + 1);
+    }
+    return result;
+}
+
+IntVector EnumeratingGridCoordinateGenerator::findBearingPath1(int vertex) const
+{
+    IntVector result;
+    int resultLength = 0;
+    foreach (const IntVector &path, m_paths)
+    {
+        IntVector currentPath = findBearingPath1(vertex, path);
+        int currentLength = pathLength(currentPath);
+        if (resultLength < currentLength)
+        {
+            resultLength = currentLength;
+            result = currentPath;
+        }
+    }
+    return result;
+}
+
+void EnumeratingGridCoordinateGenerator::computeGridCoordinates()
+{
+    m_gridCoordinates.fill(-1, m_stackCoordinates.count());
+    if ((!m_paths.isEmpty()) && (m_longestPath.count() >= 2))
+    {
+        setGridCoordinatesForPath(m_gridSpace, m_longestPath);
+        for (int vertex = 0; vertex < m_gridCoordinates.count(); vertex++)
+        {
+            if (m_gridCoordinates[vertex] == -1)
+            {
+                IntVector bearingPath = findBearingPath1(vertex);
+                if (bearingPath.count() >= 3)
+                {
+                    GridSegment subGridSpace(m_gridCoordinates[bearingPath.first()], m_gridCoordinates[bearingPath.last()]);
+                    setGridCoordinatesForPath(subGridSpace, bearingPath);
+                }
+            }
+        }
+    }
+}
+
+void EnumeratingGridCoordinateGenerator::computeGridSegmentList()
+{
+    m_gridSegmentList.clear();
+    for (int i = 0; i < m_stackSegmentList.count(); i++)
+    {
+        int vertex1 = m_vertexIndexes[i*2];
+        int vertex2 = m_vertexIndexes[i*2 + 1];
+        int grid1 = m_gridCoordinates[vertex1];
+        int grid2 = m_gridCoordinates[vertex2];
+        m_gridSegmentList << GridSegment(grid1, grid2);
+    }
+}
+
+void EnumeratingGridCoordinateGenerator::computeAll()
+{
+    computeGraph();
+    computePaths();
+    computeLongestPath();
+    computeGridSpace();
+    computeGridCoordinates();
+    computeGridSegmentList();
+}
+
+void EnumeratingGridCoordinateGenerator::reduceStackCoordinates(const DoubleVector &rawSortedStackCoordinates, const IntVector &rawSortedIndexes, DoubleVector &reducedStackCoordinates, IntVector &reducedIndexes)
+{
+    static const double samplingCoef = 10000;
+
+    if ((!rawSortedStackCoordinates.isEmpty()) && (rawSortedStackCoordinates.count() == rawSortedIndexes.count()))
+    {
+        double min = rawSortedStackCoordinates[rawSortedIndexes.first()];
+        double max = rawSortedStackCoordinates[rawSortedIndexes.last()];
+        double eps = (max - min) / samplingCoef;
+
+        reducedIndexes.resize(rawSortedIndexes.count());
+
+        // Добавляем первую координату
+        int index = rawSortedIndexes[0];
+        double lastAddedCoordinate = rawSortedStackCoordinates[index];
+        reducedIndexes[index] = 0;
+        reducedStackCoordinates << lastAddedCoordinate;
+
+        // Добавляем следующие координаты, если они отличаются более чем на eps
+        for (int i = 1; i < rawSortedStackCoordinates.count(); i++)
+        {
+            int index = rawSortedIndexes[i];
+            double coordinate = rawSortedStackCoordinates[index];
+            if (fabs(coordinate - lastAddedCoordinate) > eps)
+            {
+                reducedStackCoordinates << coordinate;
+                lastAddedCoordinate = coordinate;
+            }
+            reducedIndexes[index] = reducedStackCoordinates.count() - 1;
+        }
+    }
+}
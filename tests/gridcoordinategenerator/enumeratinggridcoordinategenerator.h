@@ -0,0 +1,56 @@
+#ifndef ENUMERATINGGRIDCOORDINATEGENERATOR_H
+#define ENUMERATINGGRIDCOORDINATEGENERATOR_H
+
+#include "gridcoordinategenerator.h"
+
+// Прежняя реализация GridCoordinateGenerator: матрица смежности и перебор всех путей графа.
+// Оставлена только как эталон для проверки; время работы растёт экспоненциально с числом вершин.
+class EnumeratingGridCoordinateGenerator
+{
+public:
+    EnumeratingGridCoordinateGenerator();
+    void setMinimalSegmentGridLength(int value);
+    int minimalSegmentGridLength() const;
+    void setStackSegmentList(const StackSegmentList &value);
+    StackSegmentList stackSegmentList() const;
+    int minimalGridSpaceLength() const;
+    void setSupposedGridSpace(const GridSegment &value);
+    GridSegment supposedGridSpace() const;
+    GridSegment gridSpace() const;
+    GridSegmentList gridSegmentList() const;
+
+private:
+    int m_minimalSegmentGridLength;
+    StackSegmentList m_stackSegmentList;
+    GridSegment m_supposedGridSpace;
+    GridSegment m_gridSpace;
+    GridSegmentList m_gridSegmentList;
+    IntVector m_vertexIndexes;
+    DoubleVector m_stackCoordinates;
+    IntVectorList m_adjacencyMatrix;
+    IntVectorList m_paths;
+    int m_maxPathLength;
+    IntVector m_longestPath;
+    IntVector m_gridCoordinates;
+
+    void buildVertexes();
+    void buildAdjacencyMatrix();
+    void computeGraph();
+    IntVectorList pathsFrom(int vertex) const;
+    int pathLength(const IntVector &path) const;
+    void computePaths();
+    void computeLongestPath();
+    void computeGridSpace();
+    IntVector gridCoordinatesForPath(const GridSegment &gridSpace, const IntVector &path) const;
+    void setGridCoordinatesForPath(const GridSegment &gridSpace, const IntVector &path);
+    IntVector findBearingPath1(int vertex, const IntVector &path) const;
+    IntVector findBearingPath1(int vertex) const;
+
+    void computeGridCoordinates();
+    void computeGridSegmentList();
+    void computeAll();
+
+    static void reduceStackCoordinates(const DoubleVector &rawSortedStackCoordinates, const IntVector &rawSortedIndexes, DoubleVector &reducedStackCoordinates, IntVector &reducedIndexes);
+};
+
+#endif // ENUMERATINGGRIDCOORDINATEGENERATOR_H
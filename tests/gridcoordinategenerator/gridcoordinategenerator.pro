@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# GridCoordinateGenerator против прежнего перебора путей графа
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+TARGET = tst_gridcoordinategenerator
+TEMPLATE = app
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_gridcoordinategenerator.cpp \
+    enumeratinggridcoordinategenerator.cpp \
+    ../../floatroutine.cpp \
+    ../../gridcoordinategenerator.cpp
+
+HEADERS  += enumeratinggridcoordinategenerator.h \
+    ../../base.h \
+    ../../floatroutine.h \
+    ../../gridcoordinategenerator.h \
+    ../../indexsortheplert.h
+
+CONFIG += c++11
@@ -0,0 +1,357 @@
+#include <QtTest>
+#include "gridcoordinategenerator.h"
+#include "enumeratinggridcoordinategenerator.h"
+
+//******************************************************************************************************
+/*!
+ *\class StackLayoutRandom
+ *\brief Воспроизводимый генератор случайных раскладок отрезков (xorshift32).
+*/
+//******************************************************************************************************
+
+class StackLayoutRandom
+{
+public:
+    explicit StackLayoutRandom(quint32 seed)
+        :m_state(seed ? seed : 1)
+    {
+    }
+
+    int bounded(int count)
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return int(m_state % quint32(count));
+    }
+
+    // Координата на сетке из lineCount линий; изредка - произвольная или смещённая на величину,
+    // меньшую точности слияния вершин
+    double coordinate(int line, int lineCount)
+    {
+        double result = double(line) / double(lineCount);
+        switch (bounded(16))
+        {
+        case 0:
+            result = double(bounded(1 << 20)) / double(1 << 20);
+            break;
+        case 1:
+            result += 1e-9;
+            break;
+        }
+        return result;
+    }
+
+    StackSegment segment(int lineCount)
+    {
+        int line1 = bounded(lineCount + 1);
+        int line2 = bounded(lineCount + 1);
+        if (line1 == line2)
+        {
+            line2 = line1 + 1;
+        }
+        double coordinate1 = coordinate(line1, lineCount);
+        double coordinate2 = coordinate(line2, lineCount);
+        return StackSegment(qMin(coordinate1, coordinate2), qMax(coordinate1, coordinate2));
+    }
+
+    StackSegmentList layout(int segmentCount, int lineCount)
+    {
+        StackSegmentList result;
+        for (int i = 0; i < segmentCount; i++)
+        {
+            result << segment(lineCount);
+        }
+        return result;
+    }
+
+private:
+    quint32 m_state;
+};
+
+// Горизонтальные отрезки листа из boxCount документов: каждый раз делится наибольший документ,
+// как при добавлении документов на лист
+static StackSegmentList tiledLayout(int boxCount)
+{
+    StackLayoutRandom random(quint32(boxCount));
+    QList<QRectF> boxes;
+    boxes << QRectF(0, 0, 1, 1);
+    while (boxes.count() < boxCount)
+    {
+        int largest = 0;
+        for (int i = 1; i < boxes.count(); i++)
+        {
+            if (boxes[largest].width()*boxes[largest].height() < boxes[i].width()*boxes[i].height())
+            {
+                largest = i;
+            }
+        }
+        QRectF box = boxes[largest];
+        double ratio = 0.3 + 0.4*random.bounded(101)/100.0;
+        if (box.width() >= box.height())
+        {
+            boxes[largest].setRight(box.left() + box.width()*ratio);
+            boxes << QRectF(QPointF(boxes[largest].right(), box.top()), box.bottomRight());
+        }
+        else
+        {
+            boxes[largest].setBottom(box.top() + box.height()*ratio);
+            boxes << QRectF(QPointF(box.left(), boxes[largest].bottom()), box.bottomRight());
+        }
+    }
+
+    StackSegmentList result;
+    foreach (const QRectF &box, boxes)
+    {
+        result << StackSegment(box.left(), box.right());
+    }
+    return result;
+}
+
+static QByteArray describe(const StackSegmentList &list)
+{
+    QStringList result;
+    foreach (const StackSegment &segment, list)
+    {
+        result << QString("<%1, %2>").arg(segment.min, 0, 'g', 17).arg(segment.max, 0, 'g', 17);
+    }
+    return result.join(", ").toLatin1();
+}
+
+static QByteArray describe(const GridSegmentList &list)
+{
+    QStringList result;
+    foreach (const GridSegment &segment, list)
+    {
+        result << QString("<%1, %2>").arg(segment.min).arg(segment.max);
+    }
+    return result.join(", ").toLatin1();
+}
+
+//******************************************************************************************************
+/*!
+ *\class TestGridCoordinateGenerator
+*/
+//******************************************************************************************************
+
+class TestGridCoordinateGenerator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesPathEnumeration_data();
+    void matchesPathEnumeration();
+    void incrementalUpdateMatchesFullComputation_data();
+    void incrementalUpdateMatchesFullComputation();
+    void dragBenchmark_data();
+    void dragBenchmark();
+};
+
+void TestGridCoordinateGenerator::matchesPathEnumeration_data()
+{
+    QTest::addColumn<int>("maximalSegmentCount");
+    QTest::addColumn<int>("maximalLineCount");
+    QTest::addColumn<int>("layoutCount");
+
+    // Перебор путей экспоненциален, поэтому раскладки небольшие
+    QTest::newRow("4 segments, 4 lines") << 4 << 4 << 20000;
+    QTest::newRow("4 segments, 12 lines") << 4 << 12 << 20000;
+    QTest::newRow("9 segments, 6 lines") << 9 << 6 << 20000;
+    QTest::newRow("9 segments, 12 lines") << 9 << 12 << 20000;
+    QTest::newRow("14 segments, 8 lines") << 14 << 8 << 5000;
+    QTest::newRow("14 segments, 16 lines") << 14 << 16 << 2000;
+}
+
+void TestGridCoordinateGenerator::matchesPathEnumeration()
+{
+    QFETCH(int, maximalSegmentCount);
+    QFETCH(int, maximalLineCount);
+    QFETCH(int, layoutCount);
+
+    StackLayoutRandom random(quint32(maximalSegmentCount*1000 + maximalLineCount));
+    for (int i = 0; i < layoutCount; i++)
+    {
+        int minimalSegmentGridLength = 1 + random.bounded(5);
+        StackSegmentList layout = random.layout(1 + random.bounded(maximalSegmentCount), 2 + random.bounded(maximalLineCount - 1));
+        GridSegment supposedGridSpace;
+        if (random.bounded(4) != 0)
+        {
+            int min = random.bounded(5);
+            supposedGridSpace = GridSegment(min, min + random.bounded(100));
+        }
+
+        GridCoordinateGenerator generator;
+        generator.setMinimalSegmentGridLength(minimalSegmentGridLength);
+        generator.setStackSegmentList(layout);
+        generator.setSupposedGridSpace(supposedGridSpace);
+
+        EnumeratingGridCoordinateGenerator reference;
+        reference.setMinimalSegmentGridLength(minimalSegmentGridLength);
+        reference.setStackSegmentList(layout);
+        reference.setSupposedGridSpace(supposedGridSpace);
+
+        QByteArray message = QByteArray("layout ") + QByteArray::number(i) + ": " + describe(layout);
+        QVERIFY2(generator.minimalGridSpaceLength() == reference.minimalGridSpaceLength(), message.constData());
+        QVERIFY2(generator.gridSpace() == reference.gridSpace(), message.constData());
+        QVERIFY2(generator.gridSegmentList() == reference.gridSegmentList(),
+                 (message + "\nexpected: " + describe(reference.gridSegmentList()) + "\nactual:   " + describe(generator.gridSegmentList())).constData());
+    }
+}
+
+void TestGridCoordinateGenerator::incrementalUpdateMatchesFullComputation_data()
+{
+    QTest::addColumn<int>("maximalSegmentCount");
+    QTest::addColumn<int>("maximalLineCount");
+    QTest::addColumn<int>("layoutCount");
+    QTest::addColumn<int>("changeCount");
+
+    QTest::newRow("4 segments, 4 lines") << 4 << 4 << 20000 << 30;
+    QTest::newRow("10 segments, 12 lines") << 10 << 12 << 5000 << 60;
+    QTest::newRow("30 segments, 10 lines") << 30 << 10 << 500 << 200;
+    QTest::newRow("70 segments, 200 lines") << 70 << 200 << 100 << 300;
+}
+
+void TestGridCoordinateGenerator::incrementalUpdateMatchesFullComputation()
+{
+    QFETCH(int, maximalSegmentCount);
+    QFETCH(int, maximalLineCount);
+    QFETCH(int, layoutCount);
+    QFETCH(int, changeCount);
+
+    // Каждое изменение, применённое к одному и тому же генератору, должно давать тот же результат,
+    // что и вычисление с нуля
+    StackLayoutRandom random(quint32(maximalSegmentCount*1000 + maximalLineCount));
+    for (int i = 0; i < layoutCount; i++)
+    {
+        int minimalSegmentGridLength = 1 + random.bounded(5);
+        int lineCount = 2 + random.bounded(maximalLineCount - 1);
+        StackSegmentList layout = random.layout(1 + random.bounded(maximalSegmentCount), lineCount);
+        GridSegment supposedGridSpace;
+        if (random.bounded(4) != 0)
+        {
+            int min = random.bounded(5);
+            supposedGridSpace = GridSegment(min, min + random.bounded(300));
+        }
+
+        GridCoordinateGenerator generator;
+        generator.setMinimalSegmentGridLength(minimalSegmentGridLength);
+        generator.setStackSegmentList(layout);
+        generator.setSupposedGridSpace(supposedGridSpace);
+        for (int j = 0; j < changeCount; j++)
+        {
+            int change = random.bounded(20);
+            if (change == 0)
+            {
+                minimalSegmentGridLength = 1 + random.bounded(5);
+                generator.setMinimalSegmentGridLength(minimalSegmentGridLength);
+            }
+            else if (change == 1)
+            {
+                int min = random.bounded(5);
+                supposedGridSpace = GridSegment(min, min + random.bounded(300));
+                generator.setSupposedGridSpace(supposedGridSpace);
+            }
+            else if (change == 2)
+            {
+                layout = random.layout(1 + random.bounded(maximalSegmentCount), lineCount);
+                generator.setStackSegmentList(layout);
+            }
+            else
+            {
+                // Перемещение или изменение размера одного отрезка: на другие линии сетки,
+                // на новую линию, за пределы остальных отрезков
+                int index = random.bounded(layout.count());
+                StackSegment segment = layout[index];
+                switch (random.bounded(4))
+                {
+                case 0:
+                    segment = random.segment(lineCount);
+                    break;
+                case 1:
+                    segment.min += (random.bounded(2001) - 1000) / 100000.0;
+                    segment.max += (random.bounded(2001) - 1000) / 100000.0;
+                    break;
+                case 2:
+                    segment.min += (random.bounded(3) - 1) / double(lineCount);
+                    segment.max += (random.bounded(3) - 1) / double(lineCount);
+                    break;
+                default:
+                    segment.max = segment.min + (1 + random.bounded(lineCount)) / double(lineCount);
+                    break;
+                }
+                layout[index] = StackSegment(qMin(segment.min, segment.max), qMax(segment.min, segment.max));
+                generator.setStackSegmentList(layout);
+            }
+
+            GridCoordinateGenerator reference;
+            reference.setMinimalSegmentGridLength(minimalSegmentGridLength);
+            reference.setStackSegmentList(layout);
+            reference.setSupposedGridSpace(supposedGridSpace);
+
+            QByteArray message = QByteArray("layout ") + QByteArray::number(i) + ", change " + QByteArray::number(j) + ": " + describe(layout);
+            QVERIFY2(generator.minimalGridSpaceLength() == reference.minimalGridSpaceLength(), message.constData());
+            QVERIFY2(generator.gridSpace() == reference.gridSpace(), message.constData());
+            QVERIFY2(generator.gridSegmentList() == reference.gridSegmentList(),
+                     (message + "\nexpected: " + describe(reference.gridSegmentList()) + "\nactual:   " + describe(generator.gridSegmentList())).constData());
+        }
+    }
+}
+
+void TestGridCoordinateGenerator::dragBenchmark_data()
+{
+    QTest::addColumn<int>("boxCount");
+    QTest::addColumn<bool>("isIncremental");
+
+    QTest::newRow("64 boxes, incremental") << 64 << true;
+    QTest::newRow("64 boxes, from scratch") << 64 << false;
+    QTest::newRow("128 boxes, incremental") << 128 << true;
+    QTest::newRow("128 boxes, from scratch") << 128 << false;
+    QTest::newRow("512 boxes, incremental") << 512 << true;
+    QTest::newRow("512 boxes, from scratch") << 512 << false;
+}
+
+void TestGridCoordinateGenerator::dragBenchmark()
+{
+    QFETCH(int, boxCount);
+    QFETCH(bool, isIncremental);
+
+    // Перетаскивание одного документа: 100 шагов по 0.07% ширины листа туда и обратно,
+    // почти каждый шаг создаёт новую линию сетки
+    static const int StepCount = 100;
+    StackSegmentList layout = tiledLayout(boxCount);
+    int index = boxCount / 3;
+    QList<StackSegmentList> steps;
+    for (int i = 0; i < StepCount; i++)
+    {
+        double offset = 0.0007 * ((i < StepCount/2) ? i : StepCount - i);
+        StackSegmentList step = layout;
+        step[index] = StackSegment(layout[index].min + offset, layout[index].max + offset);
+        steps << step;
+    }
+
+    GridCoordinateGenerator generator;
+    generator.setMinimalSegmentGridLength(4);
+    generator.setStackSegmentList(layout);
+    generator.setSupposedGridSpace(GridSegment(0, 400));
+    QBENCHMARK
+    {
+        foreach (const StackSegmentList &step, steps)
+        {
+            if (isIncremental)
+            {
+                generator.setStackSegmentList(step);
+            }
+            else
+            {
+                GridCoordinateGenerator scratch;
+                scratch.setMinimalSegmentGridLength(4);
+                scratch.setStackSegmentList(step);
+                scratch.setSupposedGridSpace(GridSegment(0, 400));
+            }
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(TestGridCoordinateGenerator)
+
+#include "tst_gridcoordinategenerator.moc"
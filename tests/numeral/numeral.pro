@@ -0,0 +1,23 @@
+#-------------------------------------------------
+#
+# Быстрая запись чисел Numeral против прежней записи через QLocale
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+TARGET = tst_numeral
+TEMPLATE = app
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_numeral.cpp \
+    ../../numeral.cpp
+
+HEADERS  += ../../numeral.h
+
+CONFIG += c++11
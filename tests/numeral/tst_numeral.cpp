@@ -0,0 +1,225 @@
+#include <QtTest>
+#include <float.h>
+#include <math.h>
+#include "numeral.h"
+
+// Прежний Numeral::toString(): QLocale::toString() и три прохода decorate*.
+// Теперь им же записываются числа, которые быстрый путь не берёт.
+static QString toStringWithLocale(const Numeral &numeral, double number)
+{
+    if (qIsNaN(number))
+    {
+        return numeral.nanStub();
+    }
+    NumeralFormat format = numeral.numberFormat();
+    double cnumber = (format.percent())? number*100.0 : number;
+    QString result = numeral.initialFormat(fabs(cnumber));
+    result = numeral.decorateTrimmingZeros(result);
+    result = numeral.decorateThousandSeparator(result);
+    result = numeral.decorateSign(result, cnumber);
+    if (format.percent())
+    {
+        result = result + numeral.locale().percent();
+    }
+    return result;
+}
+
+// Все сочетания параметров формата: знак, разделитель тысяч, точность -1..9,
+// дополнительная точность, проценты
+static QList<NumeralFormat> allFormats()
+{
+    QList<NumeralFormat> result;
+    for (int flags = 0; flags < 16; flags++)
+    {
+        for (int precision = -1; precision <= 9; precision++)
+        {
+            result << NumeralFormat((flags & 1) != 0, (flags & 2) != 0, precision, (flags & 4) != 0, (flags & 8) != 0);
+        }
+    }
+    return result;
+}
+
+//******************************************************************************************************
+/*!
+ *\class NumberRandom
+ *\brief Воспроизводимый генератор случайных чисел для записи (xorshift32).
+*/
+//******************************************************************************************************
+
+class NumberRandom
+{
+public:
+    explicit NumberRandom(quint32 seed)
+        :m_state(seed ? seed : 1)
+    {
+    }
+
+    int bounded(int count)
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return int(m_state % quint32(count));
+    }
+
+    // Курсы и их изменения разных порядков; изредка - половины на границе округления,
+    // значения около нуля и слишком большие для быстрого пути
+    double number()
+    {
+        double result = 0;
+        switch (bounded(8))
+        {
+        case 0:
+            result = (bounded(2000001) + 0.5) / pow(10.0, bounded(10));
+            break;
+        case 1:
+            result = (bounded(201) - 100) * DBL_EPSILON;
+            break;
+        case 2:
+            result = (bounded(1000000) + 1) * pow(10.0, 8 + bounded(10));
+            break;
+        case 3:
+            result = bounded(100000);
+            break;
+        default:
+            result = (double(bounded(1 << 30)) * (1 << 23) + bounded(1 << 23)) / (1 << 23) * pow(10.0, bounded(14) - 10);
+            break;
+        }
+        return (bounded(2) == 0) ? -result : result;
+    }
+
+private:
+    quint32 m_state;
+};
+
+static QList<double> randomNumbers(quint32 seed, int count)
+{
+    NumberRandom random(seed);
+    QList<double> result;
+    result << 0.0 << -0.0 << qQNaN() << qInf() << -qInf() << DBL_EPSILON << -DBL_EPSILON << 0.5 << -0.5 << 1e15 << 8796093022208.0;
+    while (result.count() < count)
+    {
+        result << random.number();
+    }
+    return result;
+}
+
+//******************************************************************************************************
+/*!
+ *\class TestNumeral
+*/
+//******************************************************************************************************
+
+class TestNumeral : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesLocalePath_data();
+    void matchesLocalePath();
+    void formatBenchmark_data();
+    void formatBenchmark();
+    void cleanup();
+
+private:
+    void addLocaleRows();
+};
+
+void TestNumeral::addLocaleRows()
+{
+    QTest::addColumn<QLocale>("locale");
+
+    QTest::newRow("C") << QLocale::c();
+    QTest::newRow("English") << QLocale(QLocale::English, QLocale::UnitedStates);
+    // Разделитель тысяч - неразрывный пробел, десятичный - запятая
+    QTest::newRow("Russian") << QLocale(QLocale::Russian, QLocale::Russia);
+    QTest::newRow("German") << QLocale(QLocale::German, QLocale::Germany);
+    // Нелатинские цифры - всегда прежний путь
+    QTest::newRow("Arabic") << QLocale(QLocale::Arabic, QLocale::Egypt);
+}
+
+void TestNumeral::cleanup()
+{
+    Numeral::setDefaultLocale(QLocale());
+}
+
+void TestNumeral::matchesLocalePath_data()
+{
+    addLocaleRows();
+}
+
+void TestNumeral::matchesLocalePath()
+{
+    QFETCH(QLocale, locale);
+
+    QList<double> numbers = randomNumbers(quint32(locale.language()), 4000);
+    Numeral::setDefaultLocale(locale);
+    foreach (const NumeralFormat &format, allFormats())
+    {
+        Numeral numeral(format, locale);
+        numeral.setNanStub("n/a");
+        foreach (double number, numbers)
+        {
+            QString expected = toStringWithLocale(numeral, number);
+            QByteArray message =
+                    QByteArray("format ") + format.formatString().toUtf8() +
+                    ", precision " + QByteArray::number(format.precision()) +
+                    ", number " + QByteArray::number(number, 'g', 17) +
+                    "\nexpected: " + expected.toUtf8() +
+                    "\nactual:   ";
+
+            QString actual = numeral.toString(number);
+            QVERIFY2(actual == expected, (message + actual.toUtf8()).constData());
+
+            QChar buffer[Numeral::BufferSize];
+            int length = numeral.toChars(number, buffer, Numeral::BufferSize);
+            QVERIFY2(QString(buffer, qMax(length, 0)) == expected, (message + QString(buffer, qMax(length, 0)).toUtf8()).constData());
+
+            if (!qIsNaN(number))
+            {
+                // Статическая запись - в локали по умолчанию
+                actual = Numeral::format(number, format);
+                QVERIFY2(actual == expected, (message + actual.toUtf8()).constData());
+            }
+        }
+    }
+}
+
+void TestNumeral::formatBenchmark_data()
+{
+    QTest::addColumn<QLocale>("locale");
+    QTest::addColumn<bool>("isLocalePath");
+
+    QTest::newRow("C, Numeral::toString") << QLocale::c() << false;
+    QTest::newRow("C, QLocale") << QLocale::c() << true;
+    QTest::newRow("Russian, Numeral::toString") << QLocale(QLocale::Russian, QLocale::Russia) << false;
+    QTest::newRow("Russian, QLocale") << QLocale(QLocale::Russian, QLocale::Russia) << true;
+}
+
+void TestNumeral::formatBenchmark()
+{
+    QFETCH(QLocale, locale);
+    QFETCH(bool, isLocalePath);
+
+    // Подписи шкалы и значения в таблице: разделитель тысяч, два знака после запятой
+    QList<double> numbers;
+    NumberRandom random(1);
+    for (int i = 0; i < 10000; i++)
+    {
+        numbers << random.bounded(10000000) / 100.0;
+    }
+    Numeral numeral(NumeralFormat(false, true, 2, false, false), locale);
+    int length = 0;
+    QBENCHMARK
+    {
+        foreach (double number, numbers)
+        {
+            length += isLocalePath ? toStringWithLocale(numeral, number).length() : numeral.toString(number).length();
+        }
+    }
+    QVERIFY(length > 0);
+}
+
+QTEST_APPLESS_MAIN(TestNumeral)
+
+#include "tst_numeral.moc"
@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# SearchPattern и SearchEngine против прежней матрицы Левенштейна
+#
+#-------------------------------------------------
+
+QT       += core network testlib
+QT       -= gui
+
+TARGET = tst_searchpattern
+TEMPLATE = app
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_searchpattern.cpp \
+    ../../currencycharttable.cpp \
+    ../../currencyinstrument.cpp \
+    ../../currencyreplyparser.cpp \
+    ../../floatroutine.cpp \
+    ../../searchcatalogue.cpp \
+    ../../searchengine.cpp \
+    ../../searchngramindex.cpp \
+    ../../searchpattern.cpp \
+    ../../searchsession.cpp \
+    ../../searchtoplist.cpp
+
+HEADERS  += ../../currencycharttable.h \
+    ../../currencyinstrument.h \
+    ../../currencyreplyparser.h \
+    ../../floatroutine.h \
+    ../../indexsortheplert.h \
+    ../../searchcatalogue.h \
+    ../../searchengine.h \
+    ../../searchngramindex.h \
+    ../../searchpattern.h \
+    ../../searchsession.h \
+    ../../searchtoplist.h \
+    ../../singletont.h
+
+CONFIG += c++11
@@ -0,0 +1,376 @@
+#include <QtTest>
+#include <limits.h>
+#include "currencyreplyparser.h"
+#include "searchengine.h"
+#include "searchpattern.h"
+#include "searchsession.h"
+
+static QByteArray readTestData(const QString &fileName)
+{
+    QFile file(QFINDTESTDATA("../data/" + fileName));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+// Прежний SearchEngine::wordDistance(): полная матрица Левенштейна, минимум последней строки
+static int matrixWordDistance(const QString &queryWord, const QString &baseWord)
+{
+    if ((queryWord.isEmpty()) || (baseWord.isEmpty()))
+    {
+        return 0;
+    }
+
+    typedef QVector<int> IntVector;
+    QList<IntVector> matrix;
+    for (int i = 0; i < queryWord.length()+1; i++)
+    {
+        IntVector row;
+        row.fill(0, baseWord.length()+1);
+        matrix << row;
+    }
+    for (int i = 0; i < queryWord.length()+1; i++)
+    {
+        matrix[i][0] = i;
+    }
+    for (int j = 0; j < baseWord.length()+1; j++)
+    {
+        matrix[0][j] = j;
+    }
+    for (int i = 1; i < queryWord.length()+1; i++)
+    {
+        for (int j = 1; j < baseWord.length()+1; j++)
+        {
+            int match = (queryWord[i-1] == baseWord[j-1]) ? 0 : 1;
+            matrix[i][j] = qMin(qMin(matrix[i-1][j] + 1, matrix[i][j-1] + 1), matrix[i-1][j-1] + match);
+        }
+    }
+
+    IntVector lastRow = matrix.last();
+    int result = lastRow[0];
+    for (int j = 1; j < lastRow.count(); j++)
+    {
+        result = qMin(result, lastRow[j]);
+    }
+    return result;
+}
+
+// Прежний SearchEngine::sentenceDistance(): лучшее слово инструмента для каждого слова запроса,
+// несовпадение позиций слов карается штрафом +1
+static int matrixSentenceDistance(const QStringList &querySentence, const QStringList &baseSentence)
+{
+    if ((querySentence.isEmpty()) || (baseSentence.isEmpty()))
+    {
+        return 0;
+    }
+    int result = 0;
+    for (int i = 0; i < querySentence.count(); i++)
+    {
+        int bestWordDistance = INT_MAX;
+        for (int j = 0; j < baseSentence.count(); j++)
+        {
+            bestWordDistance = qMin(bestWordDistance, matrixWordDistance(querySentence[i], baseSentence[j]) + ((i != j) ? 1 : 0));
+        }
+        result += bestWordDistance;
+    }
+    return result;
+}
+
+// Прежний SearchEngine::variants(): все инструменты не дальше половины длины запроса
+static CurrencyInstrumentRankedMap matrixVariants(const QList<CurrencyInstrument> &instruments, const QString &query)
+{
+    CurrencyInstrumentRankedMap result;
+    QStringList querySentence = query.toUpper().split(" ", QString::SkipEmptyParts);
+    if (!querySentence.isEmpty())
+    {
+        int summaryLength = 0;
+        foreach (const QString &queryWord, querySentence)
+        {
+            summaryLength += queryWord.length();
+        }
+        int relevance = summaryLength / 2;
+        foreach (const CurrencyInstrument &instrument, instruments)
+        {
+            QStringList baseSentence = instrument.name.toUpper().split(" ", QString::SkipEmptyParts);
+            double d = matrixSentenceDistance(querySentence, baseSentence);
+            if (d <= relevance)
+            {
+                result.insert(d, instrument);
+            }
+        }
+    }
+    return result;
+}
+
+// Варианты в порядке выдачи: расстояние и код инструмента
+static QStringList ranking(const CurrencyInstrumentRankedMap &map)
+{
+    QStringList result;
+    for (CurrencyInstrumentRankedMap::const_iterator iter = map.constBegin(); iter != map.constEnd(); ++iter)
+    {
+        result << QString("%1 %2").arg(iter.key()).arg(iter.value().id);
+    }
+    return result;
+}
+
+// Все префиксы названия - так запрос набирается с клавиатуры
+static QStringList keystrokes(const QString &text)
+{
+    QStringList result;
+    for (int i = 1; i <= text.length(); i++)
+    {
+        result << text.left(i);
+    }
+    return result;
+}
+
+//******************************************************************************************************
+/*!
+ *\class WordRandom
+ *\brief Воспроизводимый генератор пар слов для сравнения (xorshift32).
+*/
+//******************************************************************************************************
+
+class WordRandom
+{
+public:
+    WordRandom(quint32 seed, const QString &alphabet)
+        :m_state(seed ? seed : 1)
+        ,m_alphabet(alphabet)
+    {
+    }
+
+    int bounded(int count)
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return int(m_state % quint32(count));
+    }
+
+    QChar letter()
+    {
+        return m_alphabet[bounded(m_alphabet.length())];
+    }
+
+    QString word(int length)
+    {
+        QString result;
+        for (int i = 0; i < length; i++)
+        {
+            result += letter();
+        }
+        return result;
+    }
+
+    // Слово с опечатками: замены, вставки, удаления; иногда - только начало слова
+    QString edited(const QString &word)
+    {
+        QString result = word;
+        int editCount = bounded(4);
+        for (int i = 0; i < editCount; i++)
+        {
+            int position = bounded(result.length() + 1);
+            switch (bounded(3))
+            {
+            case 0:
+                if (position < result.length())
+                {
+                    result[position] = letter();
+                }
+                break;
+            case 1:
+                result.insert(position, letter());
+                break;
+            default:
+                result.remove(position, 1);
+                break;
+            }
+        }
+        if (bounded(3) == 0)
+        {
+            result = result.left(bounded(result.length() + 1));
+        }
+        return result;
+    }
+
+private:
+    quint32 m_state;
+    QString m_alphabet;
+};
+
+//******************************************************************************************************
+/*!
+ *\class TestSearchPattern
+*/
+//******************************************************************************************************
+
+class TestSearchPattern : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void distanceMatchesMatrix_data();
+    void distanceMatchesMatrix();
+    void variantsMatchMatrix();
+    void keystrokeBenchmark_data();
+    void keystrokeBenchmark();
+
+private:
+    QList<CurrencyInstrument> m_instruments;
+    QStringList m_words;
+    QString m_alphabet;
+    SearchEngine m_engine;
+};
+
+void TestSearchPattern::initTestCase()
+{
+    CurrencyInstrumentReplyParser parser;
+    parser.addData(readTestData("XML_val.xml"));
+    QVERIFY(parser.finish());
+    m_instruments = parser.instruments();
+    QVERIFY(!m_instruments.isEmpty());
+    m_engine.setInstruments(m_instruments);
+
+    foreach (const CurrencyInstrument &instrument, m_instruments)
+    {
+        m_words << instrument.name.toUpper().split(" ", QString::SkipEmptyParts);
+    }
+    foreach (const QString &word, m_words)
+    {
+        foreach (QChar c, word)
+        {
+            if (!m_alphabet.contains(c))
+            {
+                m_alphabet += c;
+            }
+        }
+    }
+}
+
+void TestSearchPattern::distanceMatchesMatrix_data()
+{
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<int>("pairCount");
+
+    // Всего 2 000 000 пар
+    QTest::newRow("query with typos, catalogue word") << 0 << 1000000;
+    QTest::newRow("random short words") << 1 << 900000;
+    // Слова длиннее 64 символов считаются матрицей, а не битовыми векторами
+    QTest::newRow("words around 64 chars") << 2 << 100000;
+}
+
+void TestSearchPattern::distanceMatchesMatrix()
+{
+    QFETCH(int, kind);
+    QFETCH(int, pairCount);
+
+    WordRandom random(quint32(kind + 1), m_alphabet);
+    for (int i = 0; i < pairCount; i++)
+    {
+        QString queryWord;
+        QString baseWord;
+        switch (kind)
+        {
+        case 0:
+            baseWord = m_words[random.bounded(m_words.count())];
+            queryWord = random.edited((random.bounded(4) == 0) ? m_words[random.bounded(m_words.count())] : baseWord);
+            break;
+        case 1:
+            queryWord = random.word(random.bounded(9));
+            baseWord = random.word(random.bounded(13));
+            break;
+        default:
+            queryWord = random.word(56 + random.bounded(17));
+            baseWord = (random.bounded(2) == 0) ? random.edited(queryWord) : random.word(random.bounded(80));
+            break;
+        }
+
+        SearchPattern pattern(queryWord);
+        int expected = matrixWordDistance(queryWord, baseWord);
+        int actual = pattern.distance(baseWord);
+        QByteArray message =
+                QByteArray("pair ") + QByteArray::number(i) + ": \"" + queryWord.toUtf8() + "\" / \"" + baseWord.toUtf8() + "\"" +
+                ", expected " + QByteArray::number(expected) + ", actual " + QByteArray::number(actual);
+        QVERIFY2(actual == expected, message.constData());
+        if (!baseWord.isEmpty())
+        {
+            int bound = pattern.lowerBound(SearchPattern::charset(baseWord.constData(), baseWord.length()), baseWord.length());
+            QVERIFY2(bound <= expected, (message + ", lower bound " + QByteArray::number(bound)).constData());
+        }
+    }
+}
+
+void TestSearchPattern::variantsMatchMatrix()
+{
+    // Каждое нажатие клавиши при наборе названий всех инструментов, с сессией и без неё
+    foreach (const CurrencyInstrument &instrument, m_instruments)
+    {
+        SearchSession session;
+        foreach (const QString &query, keystrokes(instrument.name))
+        {
+            CurrencyInstrumentRankedMap expectedMap = matrixVariants(m_instruments, query);
+            QStringList expected = ranking(expectedMap);
+            QStringList actual = ranking(m_engine.variants(query));
+            QByteArray message = QByteArray("query \"") + query.toUtf8() + "\"\nexpected: " + expected.join(", ").toUtf8();
+            QVERIFY2(actual == expected, (message + "\nactual:   " + actual.join(", ").toUtf8()).constData());
+
+            // Первые 4 варианта и равные последнему из них
+            QList<double> keys = expectedMap.keys();
+            int topCount = qMin(keys.count(), 4);
+            while ((topCount < keys.count()) && (keys[topCount] == keys[topCount-1]))
+            {
+                topCount++;
+            }
+            QStringList top = ranking(m_engine.variants(query, 4, &session));
+            QVERIFY2(top == expected.mid(0, topCount), (message + "\nactual top: " + top.join(", ").toUtf8()).constData());
+        }
+    }
+}
+
+void TestSearchPattern::keystrokeBenchmark_data()
+{
+    QTest::addColumn<int>("kind");
+
+    QTest::newRow("SearchEngine::topVariants, session") << 0;
+    QTest::newRow("SearchEngine::topVariants") << 1;
+    QTest::newRow("matrix") << 2;
+}
+
+void TestSearchPattern::keystrokeBenchmark()
+{
+    QFETCH(int, kind);
+
+    // Набор нескольких запросов по одной букве, как в SearchInput (4 варианта)
+    QStringList queries;
+    queries << keystrokes("доллар сша") << keystrokes("евро") << keystrokes("фунт стерлингов")
+            << keystrokes("швейцарский франк") << keystrokes("японская иена") << keystrokes("юань");
+    int count = 0;
+    QBENCHMARK
+    {
+        SearchSession session;
+        foreach (const QString &query, queries)
+        {
+            switch (kind)
+            {
+            case 0:
+                count += m_engine.topVariants(query, 4, &session).count();
+                break;
+            case 1:
+                count += m_engine.topVariants(query, 4).count();
+                break;
+            default:
+                count += matrixVariants(m_instruments, query).count();
+                break;
+            }
+        }
+    }
+    QVERIFY(count > 0);
+}
+
+QTEST_APPLESS_MAIN(TestSearchPattern)
+
+#include "tst_searchpattern.moc"
@@ -0,0 +1,14 @@
+#-------------------------------------------------
+#
+# Проверочные программы (QtTest): qmake && make && make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += gridcoordinategenerator \
+    currencychartstore \
+    currencyreplyparser \
+    floatscale \
+    numeral \
+    searchpattern
@@ -199,6 +199,15 @@ void Window::closeDocument()
 
 }
 
+void Window::arrangeDocuments()
+{
+    Sheet *sheet = book()->currentSheet();
+    if (sheet != NULL)
+    {
+        sheet->layer()->arrangeBoxes();
+    }
+}
+
 void Window::updateWindowsEnumMenu()
 {
     // Получаем список окон и сортируем его
@@ -444,6 +453,8 @@ void Window::initializeMenu()
     windowMenu->addAction("Предыдущая вкладка", this, SLOT(previousTab()), QKeySequence(prevTabKst));
     windowMenu->addAction("Следующая вкладка", this, SLOT(nextTab()), QKeySequence(nextTabKst));
     windowMenu->addAction("Переименовать вкладку", this, SLOT(renameTab()), QKeySequence("Ctrl+R"));
+    windowMenu->addSeparator();
+    windowMenu->addAction("Упорядочить документы", this, SLOT(arrangeDocuments()), QKeySequence("Ctrl+Shift+A"));
 }
 
 void Window::updateWindowTitle()
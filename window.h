@@ -46,6 +46,7 @@ public slots:
     void closeWindow();
     void closeTab();
     void closeDocument();
+    void arrangeDocuments();
     void updateWindowsEnumMenu();
 
 protected: